@@ -0,0 +1,182 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+import esphome.final_validate as fv
+from esphome.const import (
+    CONF_ID,
+    CONF_NAME,
+    CONF_MAC_ADDRESS,
+    CONF_PLATFORM,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+)
+from esphome.components import ble_client, sensor
+from esphome.components.esp32 import add_idf_sdkconfig_option
+from esphome.core import CORE
+from esphome.components.danfoss_eco_scanner import DanfossEcoScanner
+
+CODEOWNERS = ["@dmitry-cherkas"]
+DEPENDENCIES = ["esp32_ble_tracker"]
+# provisioned slots are climates, even without a danfoss_eco climate platform in the config
+AUTO_LOAD = ["climate", "sensor", "binary_sensor", "switch", "number"]
+
+CONF_DANFOSS_ECO_ID = 'danfoss_eco_id'
+CONF_MAX_CONNECTIONS = 'max_connections'
+CONF_CONNECTION_GAP = 'connection_gap'
+CONF_SESSION_TIMEOUT = 'session_timeout'
+CONF_SCANNER_ID = 'scanner_id'
+CONF_PRESENCE_TIMEOUT = 'presence_timeout'
+CONF_PROVISIONING = 'provisioning'
+CONF_BLE_CLIENT_ID = 'ble_client_id'
+CONF_MAX_DEVICES = 'max_devices'
+CONF_DEVICE = 'device'
+CONF_DEVICES = 'devices'
+CONF_CLIENTS = 'clients'
+CONF_HEAP_FREE = 'heap_free'
+CONF_HEAP_LOW_WATERMARK = 'heap_low_watermark'
+
+UNIT_BYTES = 'B'
+ICON_MEMORY = 'mdi:memory'
+
+HEAP_SENSOR_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_BYTES,
+    icon=ICON_MEMORY,
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC
+)
+
+eco_ns = cg.esphome_ns.namespace("danfoss_eco")
+ConnectionScheduler = eco_ns.class_("ConnectionScheduler", cg.Component)
+
+
+def device_schema(value):
+    # imported lazily, the climate platform imports this module
+    from .climate import DEVICE_SCHEMA
+    return DEVICE_SCHEMA(value)
+
+
+def validate_device_template(value):
+    value = cv.Schema({}, extra=cv.ALLOW_EXTRA)(value)
+    for key in (CONF_ID, CONF_NAME, CONF_BLE_CLIENT_ID, CONF_MAC_ADDRESS):
+        if key in value:
+            raise cv.Invalid(f"{key} is assigned to every slot automatically")
+    return value
+
+
+def expand_slots(value):
+    # every slot is a regular eTRV climate, its MAC address is assigned at runtime
+    shared = {}
+    if CONF_BLE_CLIENT_ID in value:
+        shared[CONF_BLE_CLIENT_ID] = value[CONF_BLE_CLIENT_ID]
+
+    value[CONF_DEVICES] = [
+        device_schema({
+            **value[CONF_DEVICE],
+            **shared,
+            CONF_NAME: f"{value[CONF_NAME]} {i + 1}",
+        })
+        for i in range(value[CONF_MAX_DEVICES])
+    ]
+    return value
+
+
+PROVISIONING_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            # validated as a reference by every slot, the slots lease clients from the pool without it
+            cv.Optional(CONF_BLE_CLIENT_ID): cv.validate_id_name,
+            cv.Optional(CONF_MAX_DEVICES, default=4): cv.int_range(min=1, max=16),
+            cv.Optional(CONF_NAME, default="eTRV"): cv.string,
+            cv.Optional(CONF_DEVICE, default={}): validate_device_template,
+        }
+    ),
+    expand_slots
+)
+
+
+def validate_provisioning(value):
+    if CONF_PROVISIONING not in value:
+        return value
+    if CONF_SCANNER_ID not in value:
+        raise cv.Invalid("provisioning requires scanner_id")
+    if CONF_BLE_CLIENT_ID not in value[CONF_PROVISIONING] and CONF_CLIENTS not in value:
+        raise cv.Invalid("provisioning requires either ble_client_id or the clients pool")
+    return value
+
+
+def final_validate_keep_alive(config):
+    # a connection, which is kept alive permanently, holds its slot: the other eTRVs need a spare one
+    from .climate import CONF_KEEP_ALIVE, KEEP_ALIVE_ALWAYS
+    devices = [
+        conf for conf in fv.full_config.get().get("climate", [])
+        if conf.get(CONF_PLATFORM) == "danfoss_eco" and conf.get(CONF_DANFOSS_ECO_ID) == config[CONF_ID]
+    ]
+    devices += config.get(CONF_PROVISIONING, {}).get(CONF_DEVICES, [])
+
+    kept_alive = sum(1 for conf in devices if conf.get(CONF_KEEP_ALIVE) == KEEP_ALIVE_ALWAYS)
+    required = kept_alive + (1 if len(devices) > kept_alive else 0)
+    if required > config[CONF_MAX_CONNECTIONS]:
+        raise cv.Invalid(
+            f"{kept_alive} eTRVs keep the connection alive always, which requires max_connections of at least {required}",
+            path=[CONF_MAX_CONNECTIONS]
+        )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = final_validate_keep_alive
+
+
+CONFIG_SCHEMA = cv.All(cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ConnectionScheduler),
+        # ESP32 controller supports up to 3 simultaneous BLE connections by default
+        cv.Optional(CONF_MAX_CONNECTIONS, default=1): cv.int_range(min=1, max=3),
+        cv.Optional(CONF_CONNECTION_GAP, default="2s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_SESSION_TIMEOUT, default="60s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_SCANNER_ID): cv.use_id(DanfossEcoScanner),
+        cv.Optional(CONF_PRESENCE_TIMEOUT, default="5min"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_PROVISIONING): PROVISIONING_SCHEMA,
+        # ESP32 controller supports up to 3 simultaneous BLE connections by default
+        cv.Optional(CONF_CLIENTS): cv.All(
+            cv.ensure_list(cv.use_id(ble_client.BLEClient)), cv.Length(min=1, max=3)
+        ),
+        cv.Optional(CONF_HEAP_FREE): HEAP_SENSOR_SCHEMA,
+        cv.Optional(CONF_HEAP_LOW_WATERMARK): HEAP_SENSOR_SCHEMA,
+    }
+).extend(cv.COMPONENT_SCHEMA), validate_provisioning)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    cg.add(var.set_max_connections(config[CONF_MAX_CONNECTIONS]))
+    cg.add(var.set_connection_gap(config[CONF_CONNECTION_GAP]))
+    cg.add(var.set_session_timeout(config[CONF_SESSION_TIMEOUT]))
+    cg.add(var.set_presence_timeout(config[CONF_PRESENCE_TIMEOUT]))
+
+    # ble_client discovers the services on every connection, the GATT cache serves them from flash after the first one
+    if CORE.using_esp_idf:
+        add_idf_sdkconfig_option("CONFIG_BT_GATTC_CACHE_NV_FLASH", True)
+
+    if CONF_SCANNER_ID in config:
+        scanner = await cg.get_variable(config[CONF_SCANNER_ID])
+        cg.add(var.set_scanner(scanner))
+
+    if CONF_HEAP_FREE in config:
+        sens = await sensor.new_sensor(config[CONF_HEAP_FREE])
+        cg.add(var.set_heap_free(sens))
+    if CONF_HEAP_LOW_WATERMARK in config:
+        sens = await sensor.new_sensor(config[CONF_HEAP_LOW_WATERMARK])
+        cg.add(var.set_heap_low_watermark(sens))
+
+    for client_id in config.get(CONF_CLIENTS, []):
+        client = await cg.get_variable(client_id)
+        cg.add(var.add_client(client))
+
+    if CONF_PROVISIONING in config:
+        from .climate import new_device
+        for device_config in config[CONF_PROVISIONING][CONF_DEVICES]:
+            device = await new_device(device_config)
+            cg.add(device.set_slot(True))
+            cg.add(var.register_slot(device))
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+
+#include "device.h"
+
+#ifdef USE_ESP32
+
+namespace esphome
+{
+    namespace danfoss_eco
+    {
+        // plans the vacation mode, timestamps are utc seconds, 0 for both of them cancels the planned vacation
+        template <typename... Ts>
+        class SetVacationAction : public Action<Ts...>
+        {
+        public:
+            explicit SetVacationAction(Device *device) : device_(device) {}
+
+            TEMPLATABLE_VALUE(uint32_t, start)
+            TEMPLATABLE_VALUE(uint32_t, end)
+
+            void play(Ts... x) override { this->device_->set_vacation(this->start_.value(x...), this->end_.value(x...)); }
+
+        protected:
+            Device *device_;
+        };
+
+    } // namespace danfoss_eco
+} // namespace esphome
+
+#endif // USE_ESP32
@@ -1,44 +1,147 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import climate, ble_client, sensor, binary_sensor
+from esphome import automation
+from esphome.components import climate, ble_client, sensor, binary_sensor, switch, number
 from esphome.const import (
     CONF_ID,
     CONF_NAME,
+    CONF_MAC_ADDRESS,
     
     CONF_TEMPERATURE,
     CONF_BATTERY_LEVEL,
     
     CONF_ENTITY_CATEGORY,
+    CONF_UNIT_OF_MEASUREMENT,
+    CONF_VISUAL,
+    CONF_MIN_TEMPERATURE,
+    CONF_MAX_TEMPERATURE,
     ENTITY_CATEGORY_DIAGNOSTIC,
+    ENTITY_CATEGORY_CONFIG,
     
     STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
     UNIT_PERCENT,
     UNIT_CELSIUS,
+    UNIT_MILLISECOND,
+    ICON_TIMER,
     
     CONF_DEVICE_CLASS,
     DEVICE_CLASS_BATTERY,
     DEVICE_CLASS_TEMPERATURE,
     DEVICE_CLASS_PROBLEM
 )
+from . import eco_ns, ConnectionScheduler, CONF_DANFOSS_ECO_ID, CONF_BLE_CLIENT_ID
 
 CODEOWNERS = ["@dmitry-cherkas"]
 DEPENDENCIES = ["ble_client"]
 # load zero-configuration dependencies automatically
-AUTO_LOAD = ["sensor", "binary_sensor", "esp32_ble_tracker"]
+AUTO_LOAD = ["sensor", "binary_sensor", "switch", "number", "esp32_ble_tracker", "danfoss_eco"]
 
 CONF_PIN_CODE = 'pin_code'
 CONF_SECRET_KEY = 'secret_key'
 CONF_PROBLEMS = 'problems'
+CONF_PIPELINE_DEPTH = 'pipeline_depth'
+CONF_REQUEST_TIMEOUT = 'request_timeout'
+CONF_MAX_RETRIES = 'max_retries'
+CONF_RETRY_BACKOFF = 'retry_backoff'
+CONF_WRITE_DEBOUNCE = 'write_debounce'
+CONF_MAX_SILENCE = 'max_silence'
+CONF_KEEP_ALIVE = 'keep_alive'
+CONF_CONNECTION_PARAMETERS = 'connection_parameters'
+CONF_MIN_INTERVAL = 'min_interval'
+CONF_MAX_INTERVAL = 'max_interval'
+CONF_LATENCY = 'latency'
+CONF_SUPERVISION_TIMEOUT = 'supervision_timeout'
+CONF_ADAPTIVE_POLLING = 'adaptive_polling'
+CONF_THRESHOLD = 'threshold'
+CONF_REFRESH_INTERVALS = 'refresh_intervals'
+CONF_SETTINGS = 'settings'
+CONF_ERRORS = 'errors'
+CONF_BATTERY = 'battery'
+CONF_MEMORY_USAGE = 'memory_usage'
+CONF_SESSION_DURATION = 'session_duration'
+CONF_DISCOVERY_TIME = 'discovery_time'
+CONF_SESSION_DURATION_P50 = 'session_duration_p50'
+CONF_SESSION_DURATION_P95 = 'session_duration_p95'
+CONF_SESSION_FAILURES = 'session_failures'
+CONF_ADAPTABLE_REGULATION = 'adaptable_regulation'
+CONF_DISPLAY_FLIP = 'display_flip'
+CONF_LOCK_CONTROL = 'lock_control'
+CONF_TEMPERATURE_MIN = 'temperature_min'
+CONF_TEMPERATURE_MAX = 'temperature_max'
+CONF_FROST_PROTECTION_TEMPERATURE = 'frost_protection_temperature'
+CONF_VACATION_TEMPERATURE = 'vacation_temperature'
+CONF_START = 'start'
+CONF_END = 'end'
+
+UNIT_BYTES = 'B'
+ICON_MEMORY = 'mdi:memory'
+
+KEEP_ALIVE_ALWAYS = 'always'
 
-eco_ns = cg.esphome_ns.namespace("danfoss_eco")
 DanfossEco = eco_ns.class_(
     "Device", climate.Climate, ble_client.BLEClientNode, cg.PollingComponent
 )
+SettingSwitch = eco_ns.class_("SettingSwitch", switch.Switch)
+SettingNumber = eco_ns.class_("SettingNumber", number.Number)
+SetVacationAction = eco_ns.class_("SetVacationAction", automation.Action)
+
+SETTING_SWITCHES = {
+    CONF_ADAPTABLE_REGULATION: eco_ns.SETTING_ADAPTABLE_REGULATION,
+    CONF_DISPLAY_FLIP: eco_ns.SETTING_DISPLAY_FLIP,
+    CONF_LOCK_CONTROL: eco_ns.SETTING_LOCK_CONTROL,
+}
+
+SETTING_TEMPERATURES = {
+    CONF_TEMPERATURE_MIN: eco_ns.SETTING_TEMPERATURE_MIN,
+    CONF_TEMPERATURE_MAX: eco_ns.SETTING_TEMPERATURE_MAX,
+    CONF_FROST_PROTECTION_TEMPERATURE: eco_ns.SETTING_FROST_PROTECTION_TEMPERATURE,
+    CONF_VACATION_TEMPERATURE: eco_ns.SETTING_VACATION_TEMPERATURE,
+}
+
+# setpoint range of the eTRV
+SETPOINT_RANGE = (5.0, 28.0)
+# frost protection keeps the room above this temperature, it is allowed below the setpoint range
+FROST_PROTECTION_RANGE = (4.0, 10.0)
+
+SETTING_TEMPERATURE_RANGES = {
+    CONF_TEMPERATURE_MIN: SETPOINT_RANGE,
+    CONF_TEMPERATURE_MAX: SETPOINT_RANGE,
+    CONF_FROST_PROTECTION_TEMPERATURE: FROST_PROTECTION_RANGE,
+    CONF_VACATION_TEMPERATURE: SETPOINT_RANGE,
+}
+
+SESSION_TIME_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_MILLISECOND,
+    icon=ICON_TIMER,
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC
+)
+
+SETTING_SWITCH_SCHEMA = switch.SWITCH_SCHEMA.extend(
+    {
+        cv.GenerateID(): cv.declare_id(SettingSwitch),
+        cv.Optional(CONF_ENTITY_CATEGORY, default=ENTITY_CATEGORY_CONFIG): cv.entity_category,
+    }
+)
+
+SETTING_TEMPERATURE_SCHEMA = number.NUMBER_SCHEMA.extend(
+    {
+        cv.GenerateID(): cv.declare_id(SettingNumber),
+        cv.Optional(CONF_UNIT_OF_MEASUREMENT, default=UNIT_CELSIUS): cv.string_strict,
+        cv.Optional(CONF_ENTITY_CATEGORY, default=ENTITY_CATEGORY_CONFIG): cv.entity_category,
+    }
+)
 
 def validate_secret(value):
     value = cv.string_strict(value)
     if len(value) != 32:
         raise cv.Invalid("Secret key should be exactly 16 bytes (32 chars)")
+    try:
+        bytes.fromhex(value)
+    except ValueError:
+        raise cv.Invalid("Secret key should only contain hex digits")
     return value
 
 def validate_pin(value):
@@ -49,12 +152,82 @@ def validate_pin(value):
         raise cv.Invalid("PIN code should be numeric")
     return value
 
-CONFIG_SCHEMA = (
+def validate_keep_alive(value):
+    if isinstance(value, str) and value.lower() == KEEP_ALIVE_ALWAYS:
+        return KEEP_ALIVE_ALWAYS
+    return cv.positive_time_period_milliseconds(value)
+
+CONNECTION_INTERVAL = cv.All(
+    cv.positive_time_period_milliseconds,
+    cv.Range(min=cv.TimePeriod(milliseconds=8), max=cv.TimePeriod(seconds=4))
+)
+
+CONNECTION_PARAMETERS_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_MIN_INTERVAL, default="10ms"): CONNECTION_INTERVAL,
+        cv.Optional(CONF_MAX_INTERVAL, default="30ms"): CONNECTION_INTERVAL,
+        cv.Optional(CONF_LATENCY, default=0): cv.int_range(min=0, max=499),
+        cv.Optional(CONF_SUPERVISION_TIMEOUT, default="4s"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(min=cv.TimePeriod(milliseconds=100), max=cv.TimePeriod(seconds=32))
+        ),
+    }
+)
+
+REFRESH_INTERVALS_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_TEMPERATURE, default="0s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_SETTINGS, default="1h"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_ERRORS, default="1h"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_BATTERY, default="24h"): cv.positive_time_period_milliseconds,
+    }
+)
+
+def validate_adaptive_polling(value):
+    if value[CONF_MIN_INTERVAL] > value[CONF_MAX_INTERVAL]:
+        raise cv.Invalid("min_interval should not be greater than max_interval")
+    return value
+
+def validate_visual_temperatures(value):
+    visual = value.get(CONF_VISUAL, {})
+    for key in (CONF_MIN_TEMPERATURE, CONF_MAX_TEMPERATURE):
+        if key in visual and not SETPOINT_RANGE[0] <= visual[key] <= SETPOINT_RANGE[1]:
+            raise cv.Invalid(f"{key} should be within the setpoint range of the eTRV, {SETPOINT_RANGE[0]} to {SETPOINT_RANGE[1]}°C", path=[CONF_VISUAL, key])
+    if visual.get(CONF_MIN_TEMPERATURE, SETPOINT_RANGE[0]) > visual.get(CONF_MAX_TEMPERATURE, SETPOINT_RANGE[1]):
+        raise cv.Invalid(f"{CONF_MIN_TEMPERATURE} should not be greater than {CONF_MAX_TEMPERATURE}", path=[CONF_VISUAL, CONF_MIN_TEMPERATURE])
+    return value
+
+ADAPTIVE_POLLING_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_MIN_INTERVAL, default="1min"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_MAX_INTERVAL, default="30min"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_THRESHOLD, default=0.5): cv.float_range(min=0.5, max=5.0),
+        }
+    ),
+    validate_adaptive_polling
+)
+
+# devices without ble_client_id lease a ble_client from the pool of the danfoss_eco section
+DEVICE_SCHEMA = cv.All(
     climate.CLIMATE_SCHEMA.extend(
         {
             cv.GenerateID(): cv.declare_id(DanfossEco),
+            cv.GenerateID(CONF_DANFOSS_ECO_ID): cv.use_id(ConnectionScheduler),
+            cv.Optional(CONF_BLE_CLIENT_ID): cv.use_id(ble_client.BLEClient),
+            cv.Optional(CONF_MAC_ADDRESS): cv.mac_address,
             cv.Optional(CONF_SECRET_KEY): validate_secret,
             cv.Optional(CONF_PIN_CODE): validate_pin,
+            cv.Optional(CONF_PIPELINE_DEPTH, default=2): cv.int_range(min=1, max=4),
+            cv.Optional(CONF_REQUEST_TIMEOUT, default="5s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_MAX_RETRIES, default=2): cv.int_range(min=0, max=5),
+            cv.Optional(CONF_RETRY_BACKOFF, default="500ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_WRITE_DEBOUNCE, default="1s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_MAX_SILENCE, default="1h"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_KEEP_ALIVE): validate_keep_alive,
+            cv.Optional(CONF_CONNECTION_PARAMETERS, default={}): CONNECTION_PARAMETERS_SCHEMA,
+            cv.Optional(CONF_ADAPTIVE_POLLING): ADAPTIVE_POLLING_SCHEMA,
+            cv.Optional(CONF_REFRESH_INTERVALS, default={}): REFRESH_INTERVALS_SCHEMA,
             cv.Optional(CONF_BATTERY_LEVEL): sensor.sensor_schema(
                 unit_of_measurement=UNIT_PERCENT,
                 accuracy_decimals=0,
@@ -68,6 +241,28 @@ CONFIG_SCHEMA = (
                 device_class=DEVICE_CLASS_TEMPERATURE,
                 state_class=STATE_CLASS_MEASUREMENT,
             ),
+            cv.Optional(CONF_MEMORY_USAGE): sensor.sensor_schema(
+                unit_of_measurement=UNIT_BYTES,
+                icon=ICON_MEMORY,
+                accuracy_decimals=0,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC
+            ),
+            cv.Optional(CONF_SESSION_DURATION): SESSION_TIME_SCHEMA,
+            cv.Optional(CONF_DISCOVERY_TIME): SESSION_TIME_SCHEMA,
+            cv.Optional(CONF_SESSION_DURATION_P50): SESSION_TIME_SCHEMA,
+            cv.Optional(CONF_SESSION_DURATION_P95): SESSION_TIME_SCHEMA,
+            cv.Optional(CONF_SESSION_FAILURES): sensor.sensor_schema(
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC
+            ),
+            cv.Optional(CONF_ADAPTABLE_REGULATION): SETTING_SWITCH_SCHEMA,
+            cv.Optional(CONF_DISPLAY_FLIP): SETTING_SWITCH_SCHEMA,
+            cv.Optional(CONF_LOCK_CONTROL): SETTING_SWITCH_SCHEMA,
+            cv.Optional(CONF_TEMPERATURE_MIN): SETTING_TEMPERATURE_SCHEMA,
+            cv.Optional(CONF_TEMPERATURE_MAX): SETTING_TEMPERATURE_SCHEMA,
+            cv.Optional(CONF_FROST_PROTECTION_TEMPERATURE): SETTING_TEMPERATURE_SCHEMA,
+            cv.Optional(CONF_VACATION_TEMPERATURE): SETTING_TEMPERATURE_SCHEMA,
             cv.Optional(CONF_PROBLEMS): binary_sensor.BINARY_SENSOR_SCHEMA.extend({
                 cv.Optional(CONF_NAME): cv.string,
                 cv.Optional(CONF_ENTITY_CATEGORY, default=ENTITY_CATEGORY_DIAGNOSTIC): cv.entity_category,
@@ -75,18 +270,69 @@ CONFIG_SCHEMA = (
             })
         }
     )
-    .extend(ble_client.BLE_CLIENT_SCHEMA)
-    .extend(cv.polling_component_schema("60s"))
+    .extend(cv.polling_component_schema("60s")),
+    cv.has_at_most_one_key(CONF_BLE_CLIENT_ID, CONF_MAC_ADDRESS),
+    validate_visual_temperatures
 )
 
-async def to_code(config):
+# slots of the provisioning have neither, their MAC address is assigned at runtime
+CONFIG_SCHEMA = cv.All(
+    DEVICE_SCHEMA,
+    cv.has_exactly_one_key(CONF_BLE_CLIENT_ID, CONF_MAC_ADDRESS)
+)
+
+async def new_device(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     await climate.register_climate(var, config)
-    await ble_client.register_ble_node(var, config)
-    
+    if CONF_BLE_CLIENT_ID in config:
+        await ble_client.register_ble_node(var, config)
+    else:
+        cg.add(var.set_pooled(True))
+    if CONF_MAC_ADDRESS in config:
+        cg.add(var.set_mac_address(config[CONF_MAC_ADDRESS].as_hex))
+
+    scheduler = await cg.get_variable(config[CONF_DANFOSS_ECO_ID])
+    cg.add(scheduler.register_device(var))
+    cg.add(var.set_scheduler(scheduler))
+
     cg.add(var.set_secret_key(config.get(CONF_SECRET_KEY, "")))
     cg.add(var.set_pin_code(config.get(CONF_PIN_CODE, "")))
+    cg.add(var.set_pipeline_depth(config[CONF_PIPELINE_DEPTH]))
+    cg.add(var.set_request_timeout(config[CONF_REQUEST_TIMEOUT]))
+    cg.add(var.set_max_retries(config[CONF_MAX_RETRIES]))
+    cg.add(var.set_retry_backoff(config[CONF_RETRY_BACKOFF]))
+    cg.add(var.set_write_debounce(config[CONF_WRITE_DEBOUNCE]))
+    cg.add(var.set_max_silence(config[CONF_MAX_SILENCE]))
+
+    if CONF_KEEP_ALIVE in config:
+        if config[CONF_KEEP_ALIVE] == KEEP_ALIVE_ALWAYS:
+            cg.add(var.set_keep_alive(eco_ns.KEEP_ALIVE_ALWAYS))
+        else:
+            cg.add(var.set_keep_alive(config[CONF_KEEP_ALIVE]))
+
+    refresh = config[CONF_REFRESH_INTERVALS]
+    cg.add(var.set_refresh_interval(eco_ns.PROPERTY_TEMPERATURE, refresh[CONF_TEMPERATURE]))
+    cg.add(var.set_refresh_interval(eco_ns.PROPERTY_SETTINGS, refresh[CONF_SETTINGS]))
+    cg.add(var.set_refresh_interval(eco_ns.PROPERTY_ERRORS, refresh[CONF_ERRORS]))
+    cg.add(var.set_refresh_interval(eco_ns.PROPERTY_BATTERY, refresh[CONF_BATTERY]))
+
+    if CONF_ADAPTIVE_POLLING in config:
+        polling = config[CONF_ADAPTIVE_POLLING]
+        cg.add(var.set_adaptive_polling(
+            polling[CONF_MIN_INTERVAL],
+            polling[CONF_MAX_INTERVAL],
+            polling[CONF_THRESHOLD]
+        ))
+
+
+    conn_params = config[CONF_CONNECTION_PARAMETERS]
+    cg.add(var.set_connection_params(
+        conn_params[CONF_MIN_INTERVAL],
+        conn_params[CONF_MAX_INTERVAL],
+        conn_params[CONF_LATENCY],
+        conn_params[CONF_SUPERVISION_TIMEOUT]
+    ))
     
     if CONF_BATTERY_LEVEL in config:
         sens = await sensor.new_sensor(config[CONF_BATTERY_LEVEL])
@@ -97,4 +343,67 @@ async def to_code(config):
     if CONF_PROBLEMS in config:
         b_sens = await binary_sensor.new_binary_sensor(config[CONF_PROBLEMS])
         cg.add(var.set_problems(b_sens))
-    
+    if CONF_MEMORY_USAGE in config:
+        sens = await sensor.new_sensor(config[CONF_MEMORY_USAGE])
+        cg.add(var.set_memory_usage(sens))
+    if CONF_SESSION_DURATION in config:
+        sens = await sensor.new_sensor(config[CONF_SESSION_DURATION])
+        cg.add(var.set_session_duration(sens))
+    if CONF_DISCOVERY_TIME in config:
+        sens = await sensor.new_sensor(config[CONF_DISCOVERY_TIME])
+        cg.add(var.set_discovery_time(sens))
+    if CONF_SESSION_DURATION_P50 in config:
+        sens = await sensor.new_sensor(config[CONF_SESSION_DURATION_P50])
+        cg.add(var.set_session_duration_p50(sens))
+    if CONF_SESSION_DURATION_P95 in config:
+        sens = await sensor.new_sensor(config[CONF_SESSION_DURATION_P95])
+        cg.add(var.set_session_duration_p95(sens))
+    if CONF_SESSION_FAILURES in config:
+        sens = await sensor.new_sensor(config[CONF_SESSION_FAILURES])
+        cg.add(var.set_session_failures(sens))
+
+    for key, setting in SETTING_SWITCHES.items():
+        if key in config:
+            sw = cg.new_Pvariable(config[key][CONF_ID], setting)
+            await switch.register_switch(sw, config[key])
+            cg.add(sw.set_device(var))
+            cg.add(var.add_setting(sw))
+    for key, setting in SETTING_TEMPERATURES.items():
+        if key in config:
+            num = cg.new_Pvariable(config[key][CONF_ID], setting)
+            await number.register_number(
+                num,
+                config[key],
+                min_value=SETTING_TEMPERATURE_RANGES[key][0],
+                max_value=SETTING_TEMPERATURE_RANGES[key][1],
+                step=0.5
+            )
+            cg.add(num.set_device(var))
+            cg.add(var.add_setting(num))
+
+    return var
+
+
+async def to_code(config):
+    await new_device(config)
+
+
+@automation.register_action(
+    "danfoss_eco.set_vacation",
+    SetVacationAction,
+    cv.Schema(
+        {
+            cv.Required(CONF_ID): cv.use_id(DanfossEco),
+            cv.Required(CONF_START): cv.templatable(cv.positive_int),
+            cv.Required(CONF_END): cv.templatable(cv.positive_int),
+        }
+    ),
+)
+async def set_vacation_to_code(config, action_id, template_arg, args):
+    parent = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, parent)
+    start = await cg.templatable(config[CONF_START], args, cg.uint32)
+    cg.add(var.set_start(start))
+    end = await cg.templatable(config[CONF_END], args, cg.uint32)
+    cg.add(var.set_end(end))
+    return var
@@ -0,0 +1,259 @@
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#include "command.h"
+
+#ifdef USE_ESP32
+
+namespace esphome
+{
+    namespace danfoss_eco
+    {
+        void RequestPipeline::set_properties(const array<shared_ptr<DeviceProperty>, PROPERTY_COUNT> &properties)
+        {
+            for (size_t i = 0; i < PROPERTY_COUNT; i++)
+                this->properties_[i] = properties[i].get();
+        }
+
+        bool RequestPipeline::push(CommandType type, PropertyMask properties)
+        {
+            // the device state is read (or written) as a whole, repeated requests for the same property are redundant
+            PropertyMask &queued = this->queued(type);
+            PropertyMask missing = properties & ~queued;
+            if (missing == 0)
+                return true;
+
+            if (type == CommandType::READ_MULTIPLE && __builtin_popcount(missing) == 1)
+                type = CommandType::READ;
+
+            if (!this->queue_.push({type, missing, 0, 0}))
+            {
+                this->dropped_++;
+                return false;
+            }
+
+            queued |= missing;
+            return true;
+        }
+
+        uint8_t RequestPipeline::process(esphome::ble_client::BLEClient *client, const string &name)
+        {
+            // request, which did not receive a callback in time, is considered lost
+            uint32_t now = millis();
+            for (uint8_t i = 0; i < this->in_flight_count_;)
+            {
+                if (now - this->in_flight_[i].issued_at > this->request_timeout_)
+                {
+                    Command cmd = this->in_flight_[i].command;
+                    this->remove_in_flight(i);
+                    if (cmd.type == CommandType::READ_MULTIPLE)
+                    {
+                        // no batch is issued until the late response has arrived, single reads are matched by their handles
+                        ESP_LOGD(TAG, "[%s] read-multiple timed out, reading the properties one by one: properties=%#06x", name.c_str(), cmd.properties);
+                        this->orphaned_batch_at_ = max<uint32_t>(now, 1);
+                        this->read_singly(cmd);
+                    }
+                    else
+                        this->retry(cmd, "timed out", name);
+                }
+                else
+                    i++;
+            }
+
+            uint8_t issued = 0;
+            Command cmd;
+            while (this->in_flight_count_ < this->depth_ && this->next_command(now, cmd))
+            {
+                cmd.attempts++;
+
+                uint16_t handle = 0;
+                if (!this->execute(client, cmd, handle))
+                {
+                    // the stack is likely congested, let it catch up before issuing anything else
+                    this->retry(cmd, "could not be issued", name);
+                    break;
+                }
+
+                this->in_flight_[this->in_flight_count_++] = {cmd, handle, now};
+                issued++;
+            }
+
+            return issued;
+        }
+
+        bool RequestPipeline::is_idle()
+        {
+            return this->queue_.empty() && this->in_flight_count_ == 0 && this->retries_count_ == 0;
+        }
+
+        void RequestPipeline::reset()
+        {
+            this->in_flight_count_ = 0;
+            this->retries_count_ = 0;
+            this->batch_in_flight_ = 0;
+            this->orphaned_batch_at_ = 0; // responses of the previous connection will not arrive
+        }
+
+        void RequestPipeline::clear()
+        {
+            this->reset();
+
+            Command cmd;
+            while (this->queue_.pop(cmd))
+                ;
+            this->queued_reads_ = 0;
+            this->queued_writes_ = 0;
+        }
+
+        bool RequestPipeline::next_command(uint32_t now, Command &cmd)
+        {
+            // retried commands first, unless they are still backing off
+            for (uint8_t i = 0; i < this->retries_count_; i++)
+            {
+                if ((int32_t)(now - this->retries_[i].not_before) < 0)
+                    continue;
+
+                if (this->retries_[i].type == CommandType::READ_MULTIPLE && (this->batch_in_flight() != 0 || this->is_batch_orphaned(now)))
+                    continue;
+
+                cmd = this->retries_[i];
+                this->retries_[i] = this->retries_[--this->retries_count_];
+                return true;
+            }
+
+            for (;;)
+            {
+                if (!this->queue_.peek(cmd))
+                    return false;
+
+                // read-multiple response does not carry handles, so a single batch can be in flight at any time
+                if (cmd.type == CommandType::READ_MULTIPLE && this->batch_in_flight() != 0)
+                    return false;
+
+                this->queue_.pop(cmd);
+                this->queued(cmd.type) &= ~cmd.properties;
+
+                // a queued batch would block the commands behind it until the late response has arrived, it is read one by one
+                if (cmd.type != CommandType::READ_MULTIPLE || !this->is_batch_orphaned(now))
+                    return true;
+                this->read_singly(cmd);
+            }
+        }
+
+        bool RequestPipeline::execute(esphome::ble_client::BLEClient *client, const Command &cmd, uint16_t &handle)
+        {
+            if (cmd.type == CommandType::READ_MULTIPLE)
+            {
+                // response is a concatenation of the values in the order of PropertyId
+                uint16_t handles[PROPERTY_COUNT];
+                uint8_t count = 0;
+                for (uint8_t id = 0; id < PROPERTY_COUNT; id++)
+                    if (cmd.properties & property_mask((PropertyId)id))
+                        handles[count++] = this->properties_[id]->handle;
+
+                this->batch_in_flight_ = cmd.properties;
+                if (read_multiple_request(client, handles, count))
+                    return true;
+
+                this->batch_in_flight_ = 0;
+                return false;
+            }
+
+            DeviceProperty *property = this->properties_[cmd.property()];
+            handle = property->handle;
+
+            if (cmd.type == CommandType::WRITE)
+                return static_cast<WritableProperty *>(property)->write_request(client);
+            else
+                return property->read_request(client);
+        }
+
+        void RequestPipeline::complete(CommandType type, uint16_t handle, esp_gatt_status_t status, const string &name)
+        {
+            uint8_t i = 0;
+            while (i < this->in_flight_count_ &&
+                   !(this->in_flight_[i].command.type == type &&
+                     (type == CommandType::READ_MULTIPLE || this->in_flight_[i].handle == handle)))
+                i++;
+
+            if (i == this->in_flight_count_)
+            {
+                if (type == CommandType::READ_MULTIPLE)
+                {
+                    ESP_LOGD(TAG, "[%s] late read-multiple response, dropping it", name.c_str());
+                    this->orphaned_batch_at_ = 0;
+                }
+                else
+                    ESP_LOGD(TAG, "[%s] response for untracked request: handle=%#04x", name.c_str(), handle);
+                return;
+            }
+
+            Command cmd = this->in_flight_[i].command;
+            this->remove_in_flight(i);
+
+            if (status == ESP_GATT_OK)
+                return;
+
+            if (cmd.type == CommandType::READ_MULTIPLE && status == ESP_GATT_REQ_NOT_SUPPORTED)
+            {
+                ESP_LOGW(TAG, "[%s] read-multiple is not supported, falling back to single reads", name.c_str());
+                this->read_multiple_supported_ = false;
+                this->read_singly(cmd);
+                return;
+            }
+
+            if (cmd.type == CommandType::READ_MULTIPLE && status == ESP_GATT_INVALID_ATTR_LEN)
+            {
+                // the same batch would not fit again, only this batch is read one by one
+                ESP_LOGW(TAG, "[%s] unexpected read-multiple response length, reading the properties one by one: properties=%#06x", name.c_str(), cmd.properties);
+                this->read_singly(cmd);
+                return;
+            }
+
+            this->retry(cmd, "failed", name);
+        }
+
+        void RequestPipeline::read_singly(const Command &cmd)
+        {
+            for (uint8_t id = 0; id < PROPERTY_COUNT; id++)
+                if (cmd.properties & property_mask((PropertyId)id))
+                    this->push(CommandType::READ, property_mask((PropertyId)id));
+        }
+
+        void RequestPipeline::retry(Command cmd, const char *reason, const string &name)
+        {
+            if (cmd.attempts > this->max_retries_)
+            {
+                ESP_LOGW(TAG, "[%s] request %s, giving up after %d attempts: properties=%#06x", name.c_str(), reason, cmd.attempts, cmd.properties);
+                return;
+            }
+
+            if (this->retries_count_ == MAX_PIPELINE_DEPTH)
+            {
+                ESP_LOGW(TAG, "[%s] request %s, too many retries pending: properties=%#06x", name.c_str(), reason, cmd.properties);
+                this->dropped_++;
+                return;
+            }
+
+            uint32_t backoff = this->retry_backoff_ << (cmd.attempts - 1);
+            ESP_LOGD(TAG, "[%s] request %s, retrying in %u ms: properties=%#06x", name.c_str(), reason, backoff, cmd.properties);
+
+            cmd.not_before = millis() + backoff;
+            this->retries_[this->retries_count_++] = cmd;
+        }
+
+        void RequestPipeline::remove_in_flight(uint8_t i)
+        {
+            if (this->in_flight_[i].command.type == CommandType::READ_MULTIPLE)
+                this->batch_in_flight_ = 0;
+
+            // keep the issue order, responses are matched against the oldest request first
+            for (uint8_t j = i + 1; j < this->in_flight_count_; j++)
+                this->in_flight_[j - 1] = this->in_flight_[j];
+            this->in_flight_count_--;
+        }
+
+    } // namespace danfoss_eco
+} // namespace esphome
+
+#endif // USE_ESP32
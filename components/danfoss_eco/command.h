@@ -2,7 +2,10 @@
 
 #include "esphome/components/esp32_ble_tracker/esp32_ble_tracker.h"
 
+#include <array>
+
 #include "properties.h"
+#include "ring_buffer.h"
 
 namespace esphome
 {
@@ -10,35 +13,114 @@ namespace esphome
     {
         using namespace std;
 
-        enum class CommandType
+        enum class CommandType : uint8_t
         {
             READ,
-            WRITE
+            WRITE,
+            READ_MULTIPLE
         };
 
+        inline PropertyMask property_mask(PropertyId id) { return 1 << id; }
+
+        // plain data, commands are copied by value through the queues and never allocated
         struct Command
         {
-            Command(CommandType t, shared_ptr<DeviceProperty> const &p) : type(t), property(p) {}
-
-            CommandType type; // 0 - read, 1 - write
-            shared_ptr<DeviceProperty> property;
+            CommandType type;        // 0 - read, 1 - write, 2 - read multiple
+            PropertyMask properties; // mask of PropertyId, a single bit for READ and WRITE
+            uint8_t attempts;        // number of times the request was issued
+            uint32_t not_before;     // retry backoff, millis
 
-            bool execute(esphome::ble_client::BLEClient *client)
-            {
-                if (this->type == CommandType::WRITE)
-                {
-                    WritableProperty *wp = static_cast<WritableProperty *>(this->property.get());
-                    return wp->write_request(client);
-                }
-                else
-                    return this->property->read_request(client);
-            }
+            PropertyId property() const { return (PropertyId)__builtin_ctz(this->properties); }
         };
 
-        class CommandQueue : public esphome::esp32_ble_tracker::Queue<Command>
+        // ATT allows a single outstanding request per connection, Bluedroid queues a few more in BTA layer.
+        // Keeping one extra request queued in the stack removes the gap between a response and the next request.
+        const uint8_t MAX_PIPELINE_DEPTH = 4;
+        const size_t COMMAND_QUEUE_SIZE = 16;
+        // Bluedroid drops the connection, when a request was not answered for this long
+        const uint32_t ATT_TIMEOUT = 30000;
+
+        // Issues queued commands while at most `depth` of them are in flight, tracks every in-flight request by its
+        // handle, re-issues failed or timed out requests with exponential backoff.
+        // All methods are called from the main loop, GATT responses reach it through the device event queue.
+        class RequestPipeline
         {
         public:
-            bool is_empty() { return this->q_.empty(); }
+            void set_depth(uint8_t depth) { this->depth_ = min(max(depth, (uint8_t)1), MAX_PIPELINE_DEPTH); }
+            void set_request_timeout(uint32_t request_timeout) { this->request_timeout_ = request_timeout; }
+            void set_max_retries(uint8_t max_retries) { this->max_retries_ = max_retries; }
+            void set_retry_backoff(uint32_t retry_backoff) { this->retry_backoff_ = retry_backoff; }
+            void set_properties(const array<shared_ptr<DeviceProperty>, PROPERTY_COUNT> &properties);
+
+            uint8_t depth() { return this->depth_; }
+            uint32_t request_timeout() { return this->request_timeout_; }
+            uint8_t max_retries() { return this->max_retries_; }
+            bool read_multiple_supported() { return this->read_multiple_supported_; }
+
+            // queues a command for the given properties, properties which are already queued are skipped
+            bool push(CommandType type, PropertyMask properties);
+
+            // handles timeouts, issues queued commands, returns the number of successfully issued requests
+            uint8_t process(esphome::ble_client::BLEClient *client, const string &name);
+
+            // called once the response for a request was received, the handle is not used for READ_MULTIPLE
+            void complete(CommandType type, uint16_t handle, esp_gatt_status_t status, const string &name);
+
+            // properties of the READ_MULTIPLE request in flight, at most one batch is in flight at any time
+            PropertyMask batch_in_flight() { return this->batch_in_flight_; }
+
+            // there are no queued, in-flight or retried commands
+            bool is_idle();
+
+            // drops in-flight requests, keeps the queued ones for the next session
+            void reset();
+            // drops in-flight and queued requests
+            void clear();
+
+            size_t queue_size() { return this->queue_.size(); }
+            size_t queue_high_watermark() { return this->queue_.high_watermark(); }
+            uint16_t dropped() { return this->dropped_; }
+
+            // bytes of the command storage embedded in the pipeline
+            size_t queue_memory() { return sizeof(this->queue_); }
+            size_t in_flight_memory() { return sizeof(this->in_flight_) + sizeof(this->retries_); }
+
+        private:
+            struct InFlight
+            {
+                Command command;
+                uint16_t handle;
+                uint32_t issued_at;
+            };
+
+            bool next_command(uint32_t now, Command &cmd);
+            bool execute(esphome::ble_client::BLEClient *client, const Command &cmd, uint16_t &handle);
+            void retry(Command cmd, const char *reason, const string &name);
+            void remove_in_flight(uint8_t i);
+            PropertyMask &queued(CommandType type) { return type == CommandType::WRITE ? this->queued_writes_ : this->queued_reads_; }
+            void read_singly(const Command &cmd);
+            bool is_batch_orphaned(uint32_t now) { return this->orphaned_batch_at_ != 0 && now - this->orphaned_batch_at_ < ATT_TIMEOUT; }
+
+            DeviceProperty *properties_[PROPERTY_COUNT]{nullptr};
+
+            RingBuffer<Command, COMMAND_QUEUE_SIZE> queue_;
+
+            PropertyMask batch_in_flight_ = 0;
+            InFlight in_flight_[MAX_PIPELINE_DEPTH];
+            uint8_t in_flight_count_ = 0;
+            Command retries_[MAX_PIPELINE_DEPTH];
+            uint8_t retries_count_ = 0;
+            PropertyMask queued_reads_ = 0;  // mask of properties with queued READ or READ_MULTIPLE commands
+            PropertyMask queued_writes_ = 0; // mask of properties with queued WRITE commands
+            uint16_t dropped_ = 0;      // commands dropped because a queue was full
+            // a timed out READ_MULTIPLE, its late response could not be told apart from the response of the next batch
+            uint32_t orphaned_batch_at_ = 0;
+
+            uint8_t depth_ = 2;
+            uint32_t request_timeout_ = 5000;
+            uint8_t max_retries_ = 2;
+            uint32_t retry_backoff_ = 500;
+            bool read_multiple_supported_ = true;
         };
 
     } // namespace danfoss_eco
@@ -6,94 +6,530 @@ namespace esphome
 {
   namespace danfoss_eco
   {
+    // std::allocator, which adds up the allocated bytes. The control block of a shared_ptr is of an implementation
+    // defined type, its size is only known to the allocator
+    template <typename T>
+    struct CountingAllocator
+    {
+      using value_type = T;
+
+      explicit CountingAllocator(size_t *allocated) : allocated(allocated) {}
+      template <typename U>
+      CountingAllocator(const CountingAllocator<U> &other) : allocated(other.allocated) {}
+
+      T *allocate(size_t n)
+      {
+        *this->allocated += n * sizeof(T);
+        return allocator<T>().allocate(n);
+      }
+      void deallocate(T *p, size_t n) { allocator<T>().deallocate(p, n); }
+
+      size_t *allocated;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const CountingAllocator<T> &a, const CountingAllocator<U> &b) { return a.allocated == b.allocated; }
+    template <typename T, typename U>
+    bool operator!=(const CountingAllocator<T> &a, const CountingAllocator<U> &b) { return a.allocated != b.allocated; }
+
+    // properties, which make up the device state
+    static const PropertyId STATE_PROPERTIES[] = {PROPERTY_SETTINGS, PROPERTY_TEMPERATURE, PROPERTY_ERRORS, PROPERTY_BATTERY};
+
+    void Device::call_setup()
+    {
+      this->setup();
+
+      // devices usually share the same update_interval, stagger their first poll to avoid connecting all of them at once
+      uint32_t interval = this->get_update_interval();
+      if (this->adaptive_polling_)
+      {
+        this->poll_interval_ = min(max(interval, this->min_poll_interval_), this->max_poll_interval_);
+        this->set_timeout("stagger", this->scheduler_->poll_offset(this, interval), [this]()
+                          { this->update(); });
+        return;
+      }
+
+      this->set_timeout("stagger", this->scheduler_->poll_offset(this, interval), [this, interval]()
+                        {
+                          this->update();
+                          this->set_interval("update", interval, [this]() { this->update(); });
+                        });
+    }
+
     void Device::setup()
     {
-      shared_ptr<MyComponent> sp_this(this);
+      // the blocks are counted for memory_usage(), properties are allocated together with their control blocks
+      CountingAllocator<MyComponent> alloc(&this->shared_blocks_);
+      shared_ptr<MyComponent> sp_this(this, default_delete<MyComponent>(), alloc);
 
-      this->p_pin = make_shared<WritableProperty>(sp_this, xxtea, SERVICE_SETTINGS, CHARACTERISTIC_PIN);
-      this->p_battery = make_shared<BatteryProperty>(sp_this, xxtea);
-      this->p_temperature = make_shared<TemperatureProperty>(sp_this, xxtea);
-      this->p_settings = make_shared<SettingsProperty>(sp_this, xxtea);
-      this->p_errors = make_shared<ErrorsProperty>(sp_this, xxtea);
-      this->p_secret_key = make_shared<SecretKeyProperty>(sp_this, xxtea);
+      this->p_pin = allocate_shared<WritableProperty>(alloc, sp_this, this->xxtea, PinSchema{});
+      this->p_battery = allocate_shared<BatteryProperty>(alloc, sp_this, this->xxtea);
+      this->p_temperature = allocate_shared<TemperatureProperty>(alloc, sp_this, this->xxtea);
+      this->p_settings = allocate_shared<SettingsProperty>(alloc, sp_this, this->xxtea);
+      this->p_errors = allocate_shared<ErrorsProperty>(alloc, sp_this, this->xxtea);
+      this->p_secret_key = allocate_shared<SecretKeyProperty>(alloc, sp_this, this->xxtea);
 
+      // the order should match PropertyId
       this->properties = {this->p_pin, this->p_battery, this->p_temperature, this->p_settings, this->p_errors, this->p_secret_key};
-      // pretend, we have already discovered the device
-      copy_address(this->parent()->get_address(), this->parent()->get_remote_bda());
-      this->parent()->set_state(ClientState::INIT);
+      this->pipeline_.set_properties(this->properties);
+
+      for (size_t i = 0; i < PROPERTY_COUNT; i++)
+        this->properties[i]->set_refresh_interval(this->refresh_intervals_[i]);
+
+      if (this->slot_)
+      {
+        uint32_t hash = fnv1_hash("danfoss_eco_address__" + this->get_name());
+        this->address_pref_ = global_preferences->make_preference<uint64_t>(hash, true);
+        if (!this->address_pref_.load(&this->address_))
+          this->address_ = 0;
+      }
+      else if (!this->pooled_)
+        this->address_ = this->parent()->get_address();
+
+      if (this->address_ != 0)
+        this->load_handles();
+
+      if (!this->pooled_)
+        this->parent()->set_state(ClientState::INIT);
+
+      // the footprint does not change at runtime
+      if (this->memory_usage_ != nullptr)
+        this->memory_usage_->publish_state(this->memory_usage().total());
     }
 
     void Device::loop()
     {
+      // events of a failed session are still accounted for, before the session is released
+      this->process_events();
+
       if (this->status_has_error())
       {
         this->disconnect();
         this->status_clear_error();
       }
 
-      if (this->node_state != ClientState::ESTABLISHED)
+      // the PIN write is not tracked by the pipeline, a lost response would hold the session until it times out
+      if (this->session_ && this->pin_requested_ && !this->pin_accepted_ && millis() - this->pin_written_at_ > this->pipeline_.request_timeout())
+      {
+        if (this->pin_attempts_ > this->pipeline_.max_retries())
+        {
+          ESP_LOGW(TAG, "[%s] pin write timed out, giving up after %d attempts", this->get_name().c_str(), this->pin_attempts_);
+          this->disconnect();
+          return;
+        }
+        ESP_LOGD(TAG, "[%s] pin write timed out, writing it again", this->get_name().c_str());
+        this->write_pin();
+      }
+
+      if (!this->is_established())
         return;
 
-      Command *cmd = this->commands_.pop();
-      while (cmd != nullptr)
+      if (this->read_secret_key_)
+      {
+        this->read_secret_key_ = false;
+        this->pipeline_.push(CommandType::READ, property_mask(PROPERTY_SECRET_KEY));
+      }
+
+      this->pipeline_.process(this->parent(), this->get_name());
+      if (!this->pipeline_.is_idle())
+        return;
+
+      // all responses of this session were handled, climate state is published once for all of them.
+      // A connection, which is kept alive, stays idle here between the polls
+      if (this->state_read_)
+      {
+        this->state_read_ = false;
+        this->publish_changes();
+      }
+
+      // a write was given up, the device value is read back instead of masking it with the changes
+      auto &s_data = this->p_settings->data;
+      if (s_data.has_changes() && !(this->pending_writes_ & WRITE_SETTINGS))
+      {
+        ESP_LOGW(TAG, "[%s] settings were not written, discarding the changes", this->get_name().c_str());
+        s_data.discard_changes();
+        this->confirm_writes_ |= property_mask(PROPERTY_SETTINGS);
+      }
+
+      auto &t_data = this->p_temperature->data;
+      if (t_data.has_changes() && !(this->pending_writes_ & WRITE_TEMPERATURE))
       {
-        if (cmd->execute(this->parent()))
-          this->request_counter_++;
+        ESP_LOGW(TAG, "[%s] target temperature was not written, discarding the change", this->get_name().c_str());
+        t_data.discard_changes();
+        this->confirm_writes_ |= property_mask(PROPERTY_TEMPERATURE);
+      }
 
-        delete cmd;
-        cmd = this->commands_.pop();
+      // all writes of this session have landed, read the written properties back once
+      if (this->confirm_writes_ != 0)
+      {
+        this->read_state(this->confirm_writes_ | this->due_properties());
+        this->confirm_writes_ = 0;
+        return;
       }
 
-      // once we are done with pending commands - check to see if there are any pending requests
-      // if there are no pending requests - we are done with the device for now and should disconnect
-      if (this->request_counter_ == 0)
+      if (this->poll_pending_)
+        this->adapt_poll_interval();
+
+      // once we are done with pending commands and there are no requests in flight
+      // we are done with the device for now and should disconnect, unless the connection should be kept alive
+      if (!this->is_kept_alive())
         this->disconnect();
     }
 
     void Device::update()
     {
-      this->connect();
+      // the next poll is re-scheduled once the state is read, this one keeps polling when the session fails
+      if (this->adaptive_polling_)
+        this->set_timeout("update", this->poll_interval_, [this]()
+                          { this->update(); });
 
-      if (this->xxtea->status() == XXTEA_STATUS_SUCCESS)
+      if (this->address_ == 0)
       {
-        ESP_LOGI(TAG, "[%s] requesting device state", this->get_name().c_str());
+        ESP_LOGV(TAG, "[%s] waiting for an eTRV to be provisioned", this->get_name().c_str());
+        return;
+      }
 
-        this->commands_.push(new Command(CommandType::READ, this->p_battery));
-        this->commands_.push(new Command(CommandType::READ, this->p_temperature));
-        this->commands_.push(new Command(CommandType::READ, this->p_settings));
-        this->commands_.push(new Command(CommandType::READ, this->p_errors));
+      // without the secret key the connection is only useful, once the hardware button was pressed
+      if (this->xxtea.status() == XXTEA_STATUS_NOT_INITIALIZED && !this->scheduler_->secret_key_readable(this))
+      {
+        ESP_LOGD(TAG, "[%s] waiting for the hardware button to be pressed to read the secret key", this->get_name().c_str());
+        return;
       }
+
+      // there is no reason to connect, when none of the values is due for a refresh
+      PropertyMask due = this->due_properties();
+      if (due == 0 && this->xxtea.status() == XXTEA_STATUS_SUCCESS)
+      {
+        ESP_LOGD(TAG, "[%s] all values are fresh, skipping poll", this->get_name().c_str());
+        return;
+      }
+
+      // the device is already waiting for its turn to connect, or is connected right now
+      if (!this->scheduler_->request_session(this, false))
+      {
+        // connection which is kept alive is polled in place
+        if (this->is_established() && this->xxtea.status() == XXTEA_STATUS_SUCCESS)
+          this->read_state(due);
+        return;
+      }
+
+      if (this->xxtea.status() == XXTEA_STATUS_SUCCESS)
+        this->read_state(due);
+    }
+
+    PropertyMask Device::due_properties()
+    {
+      // the next poll might be scheduled earlier than that with adaptive polling, which only means a slightly older value
+      uint32_t next_poll = this->adaptive_polling_ ? this->poll_interval_ : this->get_update_interval();
+      uint32_t now = millis();
+
+      PropertyMask due = 0;
+      for (auto id : STATE_PROPERTIES)
+        if (this->properties[id]->is_due(now, next_poll))
+          due |= property_mask(id);
+      return due;
+    }
+
+    void Device::read_state(PropertyMask properties)
+    {
+      ESP_LOGI(TAG, "[%s] requesting device state: properties=%#06x", this->get_name().c_str(), properties);
+      this->poll_pending_ = true;
+
+      if (!this->pipeline_.read_multiple_supported())
+      {
+        for (uint8_t id = 0; id < PROPERTY_COUNT; id++)
+          if (properties & property_mask((PropertyId)id))
+            this->pipeline_.push(CommandType::READ, property_mask((PropertyId)id));
+        return;
+      }
+
+      // larger values first: this packs read-multiple batches tighter
+      PropertyId ids[PROPERTY_COUNT];
+      uint8_t ids_count = 0;
+      for (uint8_t id = 0; id < PROPERTY_COUNT; id++)
+      {
+        if (!(properties & property_mask((PropertyId)id)))
+          continue;
+
+        uint8_t j = ids_count++;
+        for (; j > 0 && this->properties[ids[j - 1]]->value_length < this->properties[id]->value_length; j--)
+          ids[j] = ids[j - 1];
+        ids[j] = (PropertyId)id;
+      }
+
+      // ATT truncates read-multiple response to (MTU - 1) bytes, split the properties into batches which fit into a single response
+      uint16_t max_len = min<uint16_t>(this->mtu_ - 1, GATT_EVENT_VALUE_SIZE);
+      PropertyMask batches[PROPERTY_COUNT] = {0};
+      uint16_t batch_len[PROPERTY_COUNT] = {0};
+      uint8_t count = 0;
+      for (uint8_t k = 0; k < ids_count; k++)
+      {
+        PropertyId id = ids[k];
+        uint16_t len = this->properties[id]->value_length;
+        uint8_t i = 0;
+        while (i < count && batch_len[i] + len > max_len)
+          i++;
+
+        if (i == count)
+          count++;
+        batches[i] |= property_mask(id);
+        batch_len[i] += len;
+      }
+
+      for (uint8_t i = 0; i < count; i++)
+        this->pipeline_.push(CommandType::READ_MULTIPLE, batches[i]);
     }
 
     void Device::control(const ClimateCall &call)
     {
+      if (this->keep_alive_ > 0)
+        this->keep_alive_until_ = millis() + this->keep_alive_;
+
+      // room temperature is expected to follow the change, watch it closely
+      this->fast_poll_ = true;
+
       if (call.get_target_temperature().has_value())
       {
-        TemperatureData &t_data = (TemperatureData &)(*this->p_temperature->data);
-        t_data.target_temperature = *call.get_target_temperature();
-
-        this->commands_.push(new Command(CommandType::WRITE, this->p_temperature));
-        // initiate connection to the device
-        this->connect();
+        TemperatureData &t_data = this->p_temperature->data;
+        if (t_data.valid)
+        {
+          t_data.set_target_temperature(*call.get_target_temperature());
+          this->pending_writes_ |= WRITE_TEMPERATURE;
+        }
+        else
+          ESP_LOGW(TAG, "[%s] temperature was not read from the device yet, ignoring target_temperature", this->get_name().c_str());
       }
 
       if (call.get_mode().has_value())
       {
-        SettingsData &s_data = (SettingsData &)(*this->p_settings->data);
-        s_data.device_mode = *call.get_mode();
+        // settings are written as a whole, unknown fields can not be filled in before the first read
+        SettingsData &s_data = this->p_settings->data;
+        if (s_data.valid)
+        {
+          s_data.set_device_mode(*call.get_mode());
 
-        // update state immediately to avoid delays in HA UI
-        this->mode = s_data.device_mode;
-        this->publish_state();
+          // update state immediately to avoid delays in HA UI
+          this->mode = s_data.device_mode;
+          this->publish_climate();
 
-        this->commands_.push(new Command(CommandType::WRITE, this->p_settings));
-        // initiate connection to the device
-        this->connect();
+          this->pending_writes_ |= WRITE_SETTINGS;
+        }
+        else
+          ESP_LOGW(TAG, "[%s] settings were not read from the device yet, ignoring mode", this->get_name().c_str());
+      }
+
+      // dragging the slider in HA produces a burst of calls, only the last value should be sent to the device
+      this->set_timeout("write", this->write_debounce_, [this]()
+                        { this->flush_writes(); });
+    }
+
+    void Device::write_setting(SettingId id, float value)
+    {
+      // settings are written as a whole, unknown fields can not be filled in before the first read
+      SettingsData &s_data = this->p_settings->data;
+      if (!s_data.valid)
+      {
+        ESP_LOGW(TAG, "[%s] settings were not read from the device yet, ignoring setting %d", this->get_name().c_str(), id);
+        return;
+      }
+
+      switch (id)
+      {
+      case SETTING_ADAPTABLE_REGULATION:
+        s_data.set_adaptable_regulation(value != 0);
+        break;
+      case SETTING_DISPLAY_FLIP:
+        s_data.set_display_flip(value != 0);
+        break;
+      case SETTING_LOCK_CONTROL:
+        s_data.set_lock_control(value != 0);
+        break;
+      case SETTING_TEMPERATURE_MIN:
+        if (value > s_data.temperature_max)
+        {
+          ESP_LOGW(TAG, "[%s] temperature_min %.1f is above temperature_max %.1f, ignoring it", this->get_name().c_str(), value, s_data.temperature_max);
+          this->setting_entities_[id]->publish_setting(s_data.temperature_min, 0);
+          return;
+        }
+        s_data.set_temperature_min(value);
+        this->set_visual_min_temperature_override(s_data.temperature_min);
+        break;
+      case SETTING_TEMPERATURE_MAX:
+        if (value < s_data.temperature_min)
+        {
+          ESP_LOGW(TAG, "[%s] temperature_max %.1f is below temperature_min %.1f, ignoring it", this->get_name().c_str(), value, s_data.temperature_min);
+          this->setting_entities_[id]->publish_setting(s_data.temperature_max, 0);
+          return;
+        }
+        s_data.set_temperature_max(value);
+        this->set_visual_max_temperature_override(s_data.temperature_max);
+        break;
+      case SETTING_FROST_PROTECTION_TEMPERATURE:
+        s_data.set_frost_protection_temperature(value);
+        break;
+      case SETTING_VACATION_TEMPERATURE:
+        s_data.set_vacation_temperature(value);
+        break;
+      default:
+        return;
+      }
+
+      ESP_LOGD(TAG, "[%s] setting %d changed: %.1f", this->get_name().c_str(), id, this->get_setting(id));
+
+      // update state immediately to avoid delays in HA UI
+      if (this->setting_entities_[id] != nullptr)
+        this->setting_entities_[id]->publish_setting(this->get_setting(id), 0);
+
+      this->schedule_settings_write();
+    }
+
+    void Device::set_vacation(uint32_t from, uint32_t to)
+    {
+      SettingsData &s_data = this->p_settings->data;
+      if (!s_data.valid)
+      {
+        ESP_LOGW(TAG, "[%s] settings were not read from the device yet, ignoring vacation", this->get_name().c_str());
+        return;
+      }
+
+      ESP_LOGD(TAG, "[%s] vacation changed: from=%u, to=%u", this->get_name().c_str(), from, to);
+      s_data.set_vacation(from, to);
+      this->schedule_settings_write();
+    }
+
+    void Device::schedule_settings_write()
+    {
+      if (this->keep_alive_ > 0)
+        this->keep_alive_until_ = millis() + this->keep_alive_;
+
+      // configuring several settings produces a burst of changes, all of them are sent in a single write
+      this->pending_writes_ |= WRITE_SETTINGS;
+      this->set_timeout("write", this->write_debounce_, [this]()
+                        { this->flush_writes(); });
+    }
+
+    void Device::flush_writes()
+    {
+      if (this->pending_writes_ == 0)
+        return;
+
+      if (this->pending_writes_ & WRITE_TEMPERATURE)
+        this->pipeline_.push(CommandType::WRITE, property_mask(PROPERTY_TEMPERATURE));
+      if (this->pending_writes_ & WRITE_SETTINGS)
+        this->pipeline_.push(CommandType::WRITE, property_mask(PROPERTY_SETTINGS));
+      this->pending_writes_ = 0;
+
+      // initiate connection to the device
+      this->scheduler_->request_session(this, true);
+    }
+
+    void Device::publish_changes()
+    {
+      this->publish_settings();
+
+      auto &t_data = this->p_temperature->data;
+      auto &s_data = this->p_settings->data;
+      if (!t_data.valid && !s_data.valid)
+        return;
+
+      auto &last = this->published_;
+      bool changed = !last.valid ||
+                     last.mode != this->mode ||
+                     last.action != this->action ||
+                     !same_value(last.target_temperature, this->target_temperature) ||
+                     !same_value(last.current_temperature, this->current_temperature) ||
+                     !same_value(last.temperature_min, s_data.temperature_min) ||
+                     !same_value(last.temperature_max, s_data.temperature_max);
+
+      if (changed || heartbeat_due(millis(), this->last_publish_, this->max_silence_))
+        this->publish_climate();
+      else
+        ESP_LOGV(TAG, "[%s] state has not changed, skipping publish", this->get_name().c_str());
+    }
+
+    void Device::publish_settings()
+    {
+      if (!this->p_settings->data.valid)
+        return;
+
+      for (auto *entity : this->setting_entities_)
+        if (entity != nullptr)
+          entity->publish_setting(this->get_setting(entity->setting()), this->max_silence_);
+    }
+
+    float Device::get_setting(SettingId id)
+    {
+      auto &s_data = this->p_settings->data;
+      switch (id)
+      {
+      case SETTING_ADAPTABLE_REGULATION:
+        return s_data.get_adaptable_regulation();
+      case SETTING_DISPLAY_FLIP:
+        return s_data.get_display_flip();
+      case SETTING_LOCK_CONTROL:
+        return s_data.get_lock_control();
+      case SETTING_TEMPERATURE_MIN:
+        return s_data.temperature_min;
+      case SETTING_TEMPERATURE_MAX:
+        return s_data.temperature_max;
+      case SETTING_FROST_PROTECTION_TEMPERATURE:
+        return s_data.frost_protection_temperature;
+      case SETTING_VACATION_TEMPERATURE:
+        return s_data.vacation_temperature;
+      default:
+        return NAN;
+      }
+    }
+
+    void Device::publish_climate()
+    {
+      auto &s_data = this->p_settings->data;
+      this->published_ = {true, this->mode, this->action, this->target_temperature, this->current_temperature, s_data.temperature_min, s_data.temperature_max};
+      this->last_publish_ = millis();
+      this->publish_state();
+    }
+
+    void Device::adapt_poll_interval()
+    {
+      this->poll_pending_ = false;
+      if (!this->adaptive_polling_)
+        return;
+
+      auto &t_data = this->p_temperature->data;
+      float room = t_data.room_temperature;
+      uint32_t interval = this->poll_interval_;
+
+      if (this->fast_poll_)
+        interval = this->min_poll_interval_;
+      else if (!t_data.valid)
+        interval = this->max_poll_interval_; // the device is likely out of range, save its battery
+      else if (isnan(this->last_room_temperature_) || fabsf(room - this->last_room_temperature_) >= this->poll_threshold_)
+        interval = max(interval / 2, this->min_poll_interval_);
+      else if (t_data.target_temperature - room < this->poll_threshold_)
+        interval = min(interval * 2, this->max_poll_interval_); // the temperature is flat and the target is reached
+      // otherwise the room is still heating up, keep the interval
+
+      if (t_data.valid)
+        this->last_room_temperature_ = room;
+      this->fast_poll_ = false;
+
+      if (interval != this->poll_interval_)
+      {
+        ESP_LOGD(TAG, "[%s] poll interval: %u ms", this->get_name().c_str(), interval);
+        this->poll_interval_ = interval;
       }
+
+      // the interval is counted from the end of the session
+      this->set_timeout("update", interval, [this]()
+                        { this->update(); });
     }
 
     void Device::gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param)
     {
+      // events of a shared ble_client belong to the device, which holds the session
+      if (!this->session_)
+        return;
+
       switch (event)
       {
       case ESP_GATTC_CONNECT_EVT:
@@ -105,9 +541,17 @@ namespace esphome
 
       case ESP_GATTC_OPEN_EVT:
         if (param->open.status == ESP_GATT_OK)
+        {
           ESP_LOGV(TAG, "[%s] open, conn_id=%d", this->get_name().c_str(), param->open.conn_id);
+          if (this->keep_alive_ > 0)
+            this->update_connection_params(param->open.remote_bda);
+        }
         else
+        {
           ESP_LOGW(TAG, "[%s] failed to open, conn_id=%d, status=%#04x", this->get_name().c_str(), param->open.conn_id, param->open.status);
+          this->status_set_error(); // release the connection slot from the main loop
+        }
+        this->queue_event(event, param->open.status, 0, nullptr, 0);
         break;
 
       case ESP_GATTC_CLOSE_EVT:
@@ -119,24 +563,28 @@ namespace esphome
 
       case ESP_GATTC_DISCONNECT_EVT:
         ESP_LOGD(TAG, "[%s] disconnect, conn_id=%d, reason=%#04x", this->get_name().c_str(), param->disconnect.conn_id, (int)param->disconnect.reason);
+        this->queue_event(event, ESP_GATT_OK, 0, nullptr, 0);
         break;
 
       case ESP_GATTC_SEARCH_CMPL_EVT:
-        for (auto p : this->properties)
-          p->init_handle(this->parent());
-
-        write_pin();
+        this->queue_handles(param->search_cmpl.status);
         break;
 
       case ESP_GATTC_WRITE_CHAR_EVT:
-        if (param->write.handle == this->p_pin->handle)
-          this->on_write_pin(param->write);
-        else
-          this->on_write(param->write);
+        this->queue_event(event, param->write.status, param->write.handle, nullptr, 0);
         break;
 
       case ESP_GATTC_READ_CHAR_EVT:
-        this->on_read(param->read);
+      case ESP_GATTC_READ_MULTIPLE_EVT:
+        this->queue_event(event, param->read.status, param->read.handle, param->read.value, param->read.value_len);
+        break;
+
+      case ESP_GATTC_CFG_MTU_EVT:
+        if (param->cfg_mtu.status == ESP_GATT_OK)
+        {
+          ESP_LOGV(TAG, "[%s] mtu=%d", this->get_name().c_str(), param->cfg_mtu.mtu);
+          this->queue_event(event, param->cfg_mtu.status, 0, (const uint8_t *)&param->cfg_mtu.mtu, sizeof(uint16_t));
+        }
         break;
 
       default:
@@ -145,22 +593,230 @@ namespace esphome
       }
     }
 
+    void Device::queue_handles(esp_gatt_status_t status)
+    {
+      // runs in the BT task, the discovered services of the client are only consistent until it disconnects
+      uint16_t handles[PROPERTY_COUNT];
+      for (uint8_t id = 0; id < PROPERTY_COUNT; id++)
+        handles[id] = this->properties[id]->find_handle(this->parent());
+
+      this->queue_event(ESP_GATTC_SEARCH_CMPL_EVT, status, 0, (const uint8_t *)handles, sizeof(handles));
+    }
+
+    void Device::on_search_complete(GattEvent &param)
+    {
+      this->timeline_.discovery = param.received_at;
+
+      // handles of a failed discovery are not known, the cached ones are kept for the next session
+      uint16_t handles[PROPERTY_COUNT];
+      if (param.status != ESP_GATT_OK || param.value_len != sizeof(handles))
+      {
+        ESP_LOGW(TAG, "[%s] service discovery failed, status=%#04x", this->get_name().c_str(), param.status);
+        this->session_stats_.add_failure(param.status != ESP_GATT_OK ? param.status : ESP_GATT_ERROR);
+        this->disconnect();
+        return;
+      }
+      memcpy(handles, param.value, sizeof(handles));
+
+      HandleCacheValue cached = this->get_handles();
+      for (uint8_t id = 0; id < PROPERTY_COUNT; id++)
+        this->properties[id]->handle = handles[id];
+
+      if (this->p_pin->handle == INVALID_HANDLE)
+      {
+        ESP_LOGE(TAG, "[%s] pin characteristic was not discovered", this->get_name().c_str());
+        this->disconnect();
+        return;
+      }
+
+      // a partial discovery is used for this session, but it never replaces the cache
+      HandleCacheValue discovered = this->get_handles();
+      bool complete = none_of(discovered.handles, discovered.handles + CACHED_HANDLES_COUNT, [](uint16_t h)
+                              { return h == INVALID_HANDLE; });
+      bool stale = memcmp(&cached, &discovered, sizeof(HandleCacheValue)) != 0;
+      if (complete && (stale || !this->handles_cached_))
+        this->save_handles(discovered);
+
+      // PIN written to a stale handle will not be accepted, re-write it using the discovered one
+      if (!this->pin_requested_ || (stale && !this->pin_accepted_))
+        this->write_pin();
+      else if (this->pin_accepted_)
+        this->node_state = ClientState::ESTABLISHED; // ble_client resets the state of its nodes once the discovery is completed
+    }
+
+    void Device::load_handles()
+    {
+      uint32_t hash = fnv1_hash("danfoss_eco_handles__" + format_address(this->address_));
+      this->handles_pref_ = global_preferences->make_preference<HandleCacheValue>(hash, true);
+
+      HandleCacheValue cache;
+      if (!this->handles_pref_.load(&cache))
+        return;
+
+      if (any_of(cache.handles, cache.handles + CACHED_HANDLES_COUNT, [](uint16_t h)
+                 { return h == INVALID_HANDLE; }))
+      {
+        ESP_LOGW(TAG, "[%s] cached characteristic handles are incomplete, waiting for the service discovery", this->get_name().c_str());
+        return;
+      }
+
+      auto properties = this->cached_properties();
+      for (size_t i = 0; i < CACHED_HANDLES_COUNT; i++)
+        properties[i]->handle = cache.handles[i];
+
+      this->handles_cached_ = true;
+      ESP_LOGD(TAG, "[%s] characteristic handles were loaded from flash", this->get_name().c_str());
+    }
+
+    void Device::save_handles(HandleCacheValue &value)
+    {
+      this->handles_pref_.save(&value);
+      global_preferences->sync();
+
+      this->handles_cached_ = true;
+      ESP_LOGD(TAG, "[%s] characteristic handles were saved to flash", this->get_name().c_str());
+    }
+
+    HandleCacheValue Device::get_handles()
+    {
+      HandleCacheValue value;
+      auto properties = this->cached_properties();
+      for (size_t i = 0; i < CACHED_HANDLES_COUNT; i++)
+        value.handles[i] = properties[i]->handle;
+      return value;
+    }
+
+    array<shared_ptr<DeviceProperty>, CACHED_HANDLES_COUNT> Device::cached_properties()
+    {
+      // the order defines the layout of HandleCacheValue, it should never change
+      return {this->p_pin, this->p_battery, this->p_temperature, this->p_settings, this->p_errors};
+    }
+
+    void Device::update_connection_params(esp_bd_addr_t remote_bda)
+    {
+      esp_ble_conn_update_params_t conn_params = {0};
+      memcpy(conn_params.bda, remote_bda, sizeof(esp_bd_addr_t));
+      conn_params.min_int = this->conn_params_.min_interval * 4 / 5; // 1.25 ms units
+      conn_params.max_int = this->conn_params_.max_interval * 4 / 5;
+      conn_params.latency = this->conn_params_.latency;
+      conn_params.timeout = this->conn_params_.supervision_timeout / 10; // 10 ms units
+
+      auto status = esp_ble_gap_update_conn_params(&conn_params);
+      if (status != ESP_OK)
+        ESP_LOGW(TAG, "[%s] esp_ble_gap_update_conn_params failed, status=%01x", this->get_name().c_str(), status);
+    }
+
+    bool Device::is_kept_alive()
+    {
+      return this->keep_alive_ == KEEP_ALIVE_ALWAYS || (this->keep_alive_ > 0 && (int32_t)(this->keep_alive_until_ - millis()) > 0);
+    }
+
     void Device::write_pin()
     {
       ESP_LOGD(TAG, "[%s] writing pin", this->get_name().c_str());
+      this->pin_requested_ = true;
+      this->pin_written_at_ = millis();
+      this->pin_attempts_++;
 
-      uint8_t pin_bytes[sizeof(uint32_t)];
-      write_int(pin_bytes, 0, this->pin_code_);
+      uint8_t pin_bytes[PinSchema::LENGTH];
+      PinSchema::pin_code::encode(pin_bytes, this->pin_code_);
 
       if (!this->p_pin->write_request(this->parent(), pin_bytes, sizeof(pin_bytes)))
         this->status_set_error();
     }
 
-    void Device::on_read(esp_ble_gattc_cb_param_t::gattc_read_char_evt_param param)
+    void Device::queue_event(esp_gattc_cb_event_t event, esp_gatt_status_t status, uint16_t handle, const uint8_t *value, uint16_t value_len)
     {
-      this->request_counter_--;
+      // runs in the BT task, which should get the control back as soon as possible: only copy the response here
+      GattEvent e;
+      e.event = event;
+      e.status = status;
+      e.received_at = millis();
+      e.handle = handle;
+      e.value_len = 0;
+
+      if (value_len > GATT_EVENT_VALUE_SIZE)
+      {
+        // handled as a failed request, which is retried by the pipeline
+        ESP_LOGW(TAG, "[%s] response is too long: handle=%#04x, length=%d", this->get_name().c_str(), handle, value_len);
+        if (e.status == ESP_GATT_OK)
+          e.status = ESP_GATT_INVALID_ATTR_LEN;
+      }
+      else if (value != nullptr)
+      {
+        memcpy(e.value, value, value_len);
+        e.value_len = value_len;
+      }
+
+      // a dropped response is handled by the pipeline as a timed out request
+      if (!this->gatt_events_.push(e))
+      {
+        this->gatt_events_dropped_++;
+        ESP_LOGW(TAG, "[%s] GATT event queue is full, dropping event=%d, handle=%#04x", this->get_name().c_str(), (int)event, handle);
+      }
+    }
+
+    void Device::process_events()
+    {
+      GattEvent e;
+      while (this->gatt_events_.pop(e))
+      {
+        switch (e.event)
+        {
+        case ESP_GATTC_OPEN_EVT:
+          this->timeline_.open = e.received_at;
+          if (e.status != ESP_GATT_OK)
+            this->session_stats_.add_failure(e.status);
+          // with cached handles there is no need to wait for the service discovery, it will only be used to verify the cache
+          else if (this->handles_cached_ && this->xxtea.status() == XXTEA_STATUS_SUCCESS)
+            this->write_pin();
+          break;
+
+        case ESP_GATTC_SEARCH_CMPL_EVT:
+          this->on_search_complete(e);
+          break;
+
+        case ESP_GATTC_DISCONNECT_EVT:
+          // the eTRV dropped the link: free the connection slot right away instead of waiting for the session timeout.
+          // Unsent changes are discarded and read back by the next session
+          ESP_LOGW(TAG, "[%s] connection lost, ending the session", this->get_name().c_str());
+          this->pin_accepted_ = false;
+          this->pipeline_.clear();
+          this->disconnect();
+          break;
+
+        case ESP_GATTC_CFG_MTU_EVT:
+          memcpy(&this->mtu_, e.value, sizeof(this->mtu_));
+          break;
+
+        case ESP_GATTC_WRITE_CHAR_EVT:
+          if (e.handle == this->p_pin->handle)
+            this->on_write_pin(e);
+          else
+            this->on_write(e);
+          break;
+
+        case ESP_GATTC_READ_CHAR_EVT:
+          this->on_read(e);
+          break;
+
+        case ESP_GATTC_READ_MULTIPLE_EVT:
+          this->on_read_multiple(e);
+          break;
+
+        default:
+          break;
+        }
+      }
+    }
+
+    void Device::on_read(GattEvent &param)
+    {
+      this->pipeline_.complete(CommandType::READ, param.handle, param.status, this->get_name());
+      this->timeline_.response = param.received_at;
       if (param.status != ESP_GATT_OK)
       {
+        this->session_stats_.add_failure(param.status);
         ESP_LOGW(TAG, "[%s] failed to read characteristic: handle=%#04x, status=%#04x", this->get_name().c_str(), param.handle, param.status);
         return;
       }
@@ -170,49 +826,141 @@ namespace esphome
                                      { return p->handle == param.handle; });
 
       if (device_property != properties.end())
-        (*device_property)->update_state(param.value, param.value_len);
+      {
+        if ((*device_property)->update_state(param.value, param.value_len))
+        {
+          (*device_property)->mark_read(millis());
+          this->state_read_ = true;
+        }
+      }
       else
         ESP_LOGW(TAG, "[%s] unknown property with handle=%#04x", this->get_name().c_str(), param.handle);
     }
 
-    void Device::on_write(esp_ble_gattc_cb_param_t::gattc_write_evt_param param)
+    void Device::on_read_multiple(GattEvent &param)
     {
-      this->request_counter_--;
+      PropertyMask batch = this->pipeline_.batch_in_flight();
+      if (batch == 0)
+      {
+        // the response of a timed out batch, the pipeline drops it
+        this->pipeline_.complete(CommandType::READ_MULTIPLE, 0, param.status, this->get_name());
+        return;
+      }
+
+      uint16_t expected_len = 0;
+      for (uint8_t id = 0; id < PROPERTY_COUNT; id++)
+        if (batch & property_mask((PropertyId)id))
+          expected_len += this->properties[id]->value_length;
+
+      this->timeline_.response = param.received_at;
+      esp_gatt_status_t status = param.status;
+      if (status == ESP_GATT_OK && param.value_len != expected_len)
+      {
+        ESP_LOGW(TAG, "[%s] unexpected read-multiple response length: %d (expected %d)", this->get_name().c_str(), param.value_len, expected_len);
+        status = ESP_GATT_INVALID_ATTR_LEN;
+      }
+
+      if (status == ESP_GATT_OK)
+      {
+        // values are concatenated in the order of PropertyId
+        uint16_t offset = 0;
+        for (uint8_t id = 0; id < PROPERTY_COUNT; id++)
+        {
+          if (!(batch & property_mask((PropertyId)id)))
+            continue;
+
+          auto p = this->properties[id];
+          if (p->update_state(param.value + offset, p->value_length))
+          {
+            p->mark_read(millis());
+            this->state_read_ = true;
+          }
+          offset += p->value_length;
+        }
+      }
+      else
+        this->session_stats_.add_failure(status);
+
+      this->pipeline_.complete(CommandType::READ_MULTIPLE, 0, status, this->get_name());
+    }
+
+    void Device::on_write(GattEvent &param)
+    {
+      this->pipeline_.complete(CommandType::WRITE, param.handle, param.status, this->get_name());
+      this->timeline_.response = param.received_at;
       if (param.status != ESP_GATT_OK)
+      {
         ESP_LOGW(TAG, "[%s] failed to write characteristic: handle=%#04x, status=%#04x", this->get_name().c_str(), param.handle, param.status);
+        this->session_stats_.add_failure(param.status);
+      }
       else
-        update();
+      {
+        // idle window starts once the change has landed
+        if (this->keep_alive_ > 0)
+          this->keep_alive_until_ = millis() + this->keep_alive_;
+
+        for (uint8_t id = 0; id < PROPERTY_COUNT; id++)
+          if (this->properties[id]->handle == param.handle)
+            this->confirm_writes_ |= property_mask((PropertyId)id);
+
+        if (param.handle == this->p_settings->handle)
+          this->p_settings->data.commit();
+        else if (param.handle == this->p_temperature->handle)
+          this->p_temperature->data.commit();
+      }
     }
 
-    void Device::on_write_pin(esp_ble_gattc_cb_param_t::gattc_write_evt_param param)
+    void Device::on_write_pin(GattEvent &param)
     {
+      if (param.status == ESP_GATT_INVALID_HANDLE && this->handles_cached_)
+      {
+        // the firmware was likely updated, PIN will be written again once the discovery is completed
+        ESP_LOGW(TAG, "[%s] cached pin handle is invalid, waiting for the service discovery", this->get_name().c_str());
+        this->handles_cached_ = false;
+        this->pin_requested_ = false;
+        return;
+      }
+
       if (param.status != ESP_GATT_OK)
       {
         ESP_LOGE(TAG, "[%s] pin FAILED, status=%#04x", this->get_name().c_str(), param.status);
+        this->session_stats_.add_failure(param.status);
         this->disconnect();
         this->mark_failed();
         return;
       }
 
       ESP_LOGD(TAG, "[%s] pin OK", this->get_name().c_str());
+      this->timeline_.pin = param.received_at;
+      this->pin_accepted_ = true;
       this->node_state = ClientState::ESTABLISHED;
 
       // after PIN is written, we might need to read the secret_key from the device
-      if (this->xxtea->status() == XXTEA_STATUS_NOT_INITIALIZED && this->p_secret_key->handle != INVALID_HANDLE)
+      if (this->xxtea.status() == XXTEA_STATUS_NOT_INITIALIZED && this->p_secret_key->handle != INVALID_HANDLE &&
+          this->scheduler_->secret_key_readable(this))
       {
         ESP_LOGD(TAG, "[%s] attempting to read the device secret_key", this->get_name().c_str());
-        this->commands_.push(new Command(CommandType::READ, this->p_secret_key));
+        this->read_secret_key_ = true; // command queue is only fed from the main loop
       }
     }
 
     void Device::connect()
     {
-      if (this->node_state == ClientState::INIT || this->node_state == ClientState::ESTABLISHED)
+      auto state = this->parent()->state();
+      if (state == ClientState::INIT || state == ClientState::ESTABLISHED)
       {
         return;
       }
 
-      if (this->xxtea->status() == XXTEA_STATUS_NOT_INITIALIZED)
+      this->pin_requested_ = false;
+      this->pin_accepted_ = false;
+      this->pin_attempts_ = 0;
+      this->mtu_ = ESP_GATT_DEF_BLE_MTU_SIZE; // read-multiple batches are sized by the MTU of this link, once it is negotiated
+      this->session_ = true;
+      this->timeline_ = {0};
+      this->timeline_.connect = millis();
+
+      if (this->xxtea.status() == XXTEA_STATUS_NOT_INITIALIZED)
         ESP_LOGI(TAG, "[%s] Short press Danfoss Eco hardware button NOW in order to allow reading the secret key", this->get_name().c_str());
 
       if (!parent()->enabled)
@@ -220,15 +968,143 @@ namespace esphome
         ESP_LOGD(TAG, "[%s] re-enabling ble_client", this->get_name().c_str());
         parent()->set_enabled(true);
       }
-      // gap scanning interferes with connection attempts, which results in esp_gatt_status_t::ESP_GATT_ERROR (0x85)
-      esp_ble_gap_stop_scanning();
+
+      // pretend, we have already discovered the device
+      this->parent()->set_address(this->address_);
+      copy_address(this->address_, this->parent()->get_remote_bda());
       this->parent()->set_state(ClientState::READY_TO_CONNECT); // this will cause ble_client to attempt connect() from its loop()
     }
 
     void Device::disconnect()
     {
-      this->parent()->set_enabled(false);
+      // session is successful, when all requests to the device were completed
+      bool success = this->is_established() && this->pipeline_.is_idle();
+      bool session = this->session_.load();
+      this->pipeline_.reset();
+
+      // the BT task stops queueing events first, so none of this session is left for the next one
+      this->session_ = false;
+      GattEvent e;
+      while (this->gatt_events_.pop(e))
+        ;
+
+      // a pooled device, which has never leased a ble_client, has no parent
+      if (this->parent() != nullptr)
+        this->parent()->set_enabled(false);
       this->node_state = ClientState::IDLE;
+      if (session)
+        this->finish_session(success);
+      this->scheduler_->release_session(this, success);
+    }
+
+    void Device::finish_session(bool success)
+    {
+      auto &t = this->timeline_;
+      auto &stats = this->session_stats_;
+      uint32_t duration = millis() - t.connect;
+
+      // phases are relative to connect(), -1 - the phase was not reached
+      auto since_connect = [&t](uint32_t at)
+      { return at != 0 ? (int32_t)(at - t.connect) : -1; };
+      ESP_LOGD(TAG, "[%s] session timeline: open=%d ms, pin=%d ms, discovery=%d ms, last response=%d ms, disconnect=%u ms",
+               this->get_name().c_str(), since_connect(t.open), since_connect(t.pin), since_connect(t.discovery),
+               since_connect(t.response), duration);
+
+      stats.sessions++;
+      if (t.discovery != 0)
+        stats.last_discovery = t.discovery - t.connect;
+
+      if (!success)
+      {
+        stats.failures++;
+        if (this->session_failures_ != nullptr)
+          this->session_failures_->publish_state(stats.failures);
+        return;
+      }
+
+      stats.last_duration = duration;
+      stats.add_duration(duration);
+
+      if (this->session_duration_ != nullptr)
+        this->session_duration_->publish_state(duration);
+      if (this->discovery_time_ != nullptr && t.discovery != 0)
+        this->discovery_time_->publish_state(stats.last_discovery);
+      if (this->session_duration_p50_ != nullptr)
+        this->session_duration_p50_->publish_state(stats.percentile(50));
+      if (this->session_duration_p95_ != nullptr)
+        this->session_duration_p95_->publish_state(stats.percentile(95));
+    }
+
+    void SessionStats::add_duration(uint32_t duration)
+    {
+      this->durations[this->durations_next] = duration;
+      this->durations_next = (this->durations_next + 1) % SESSION_WINDOW;
+      if (this->durations_count < SESSION_WINDOW)
+        this->durations_count++;
+    }
+
+    void SessionStats::add_failure(esp_gatt_status_t status)
+    {
+      for (uint8_t i = 0; i < this->statuses_count; i++)
+      {
+        if (this->statuses[i].status == status)
+        {
+          this->statuses[i].count++;
+          return;
+        }
+      }
+
+      if (this->statuses_count < FAILURE_STATUSES)
+        this->statuses[this->statuses_count++] = {status, 1};
+      else
+        this->other_statuses++;
+    }
+
+    uint32_t SessionStats::percentile(uint8_t p) const
+    {
+      if (this->durations_count == 0)
+        return 0;
+
+      // nearest-rank over the window, it is small enough to sort a copy
+      uint32_t sorted[SESSION_WINDOW];
+      copy(this->durations, this->durations + this->durations_count, sorted);
+      sort(sorted, sorted + this->durations_count);
+
+      size_t rank = (p * this->durations_count + 99) / 100;
+      return sorted[rank > 0 ? rank - 1 : 0];
+    }
+
+    MemoryUsage Device::memory_usage()
+    {
+      static_assert(PROPERTY_COUNT == 6, "memory_usage() should account for every property");
+
+      MemoryUsage usage;
+      usage.device = sizeof(Device);
+      usage.pipeline = sizeof(RequestPipeline);
+      usage.command_queue = this->pipeline_.queue_memory();
+      usage.in_flight = this->pipeline_.in_flight_memory();
+      usage.gatt_events = sizeof(this->gatt_events_);
+      usage.key = sizeof(XxteaKey);
+
+      usage.properties = sizeof(WritableProperty) + sizeof(BatteryProperty) + sizeof(TemperatureProperty) +
+                         sizeof(SettingsProperty) + sizeof(ErrorsProperty) + sizeof(SecretKeyProperty);
+      usage.property_count = PROPERTY_COUNT;
+      usage.data = sizeof(TemperatureData) + sizeof(SettingsData) + sizeof(ErrorsData);
+      usage.data_count = 3;
+
+      // the blocks allocated by setup(), less the properties placed in them
+      usage.control_blocks = this->shared_blocks_ > usage.properties ? this->shared_blocks_ - usage.properties : 0;
+      return usage;
+    }
+
+    void Device::bind(uint64_t address)
+    {
+      ESP_LOGI(TAG, "[%s] provisioned eTRV, MAC: %s", this->get_name().c_str(), format_address(address).c_str());
+      this->address_ = address;
+      this->address_pref_.save(&this->address_);
+      global_preferences->sync();
+
+      this->load_handles();
     }
 
     void Device::set_pin_code(const string &str)
@@ -249,7 +1125,11 @@ namespace esphome
       {
         uint8_t buff[SECRET_KEY_LENGTH];
         ESP_LOGD(TAG, "[%s] secret_key was passed via config", this->get_name().c_str());
-        parse_hex_str(str.c_str(), 32, buff);
+        if (str.length() != SECRET_KEY_LENGTH * 2 || !parse_hex_str(str.c_str(), str.length(), buff))
+        {
+          ESP_LOGE(TAG, "[%s] secret_key should be %d hex digits, ignoring it", this->get_name().c_str(), SECRET_KEY_LENGTH * 2);
+          return;
+        }
         this->set_secret_key(buff, false);
       }
       else
@@ -268,7 +1148,7 @@ namespace esphome
     {
       ESP_LOGD(TAG, "[%s] secret_key bytes: %s", this->get_name().c_str(), format_hex_pretty(key, SECRET_KEY_LENGTH).c_str());
 
-      int status = this->xxtea->set_key(key, SECRET_KEY_LENGTH);
+      int status = this->xxtea.set(key, SECRET_KEY_LENGTH);
       if (status != XXTEA_STATUS_SUCCESS)
       {
         ESP_LOGE(TAG, "xxtea initialization failed, status: %d", status);
@@ -9,10 +9,14 @@
 #include "command.h"
 #include "properties.h"
 #include "my_component.h"
+#include "scheduler.h"
+#include "settings.h"
 #include "xxtea.h"
 
 #ifdef USE_ESP32
 
+#include <array>
+#include <cmath>
 #include <esp_gattc_api.h>
 
 namespace esphome
@@ -22,20 +26,160 @@ namespace esphome
     using namespace std;
     using namespace climate;
 
+    // properties with changes waiting for the write debounce window to pass
+    enum PendingWrite : uint8_t
+    {
+      WRITE_TEMPERATURE = 1 << 0,
+      WRITE_SETTINGS = 1 << 1
+    };
+
+    // keep the connection open permanently, intended for mains-powered test rigs
+    const uint32_t KEEP_ALIVE_ALWAYS = UINT32_MAX;
+
+    // GATT events are copied by the BT task into a queue and handled in the main loop, the BT task does not change the device state
+    const uint16_t GATT_EVENT_VALUE_SIZE = 40; // fits the whole device state in a single read-multiple response
+    const size_t GATT_EVENT_QUEUE_SIZE = 8;
+    static_assert(PROPERTY_COUNT * sizeof(uint16_t) <= GATT_EVENT_VALUE_SIZE, "discovered handles should fit into a GATT event");
+
+    struct GattEvent
+    {
+      esp_gattc_cb_event_t event;
+      esp_gatt_status_t status;
+      uint32_t received_at; // millis, the event might wait in the queue for a while
+      uint16_t handle;
+      uint16_t value_len;
+      uint8_t value[GATT_EVENT_VALUE_SIZE];
+    };
+
+    struct ConnectionParams
+    {
+      uint32_t min_interval;        // ms
+      uint32_t max_interval;        // ms
+      uint16_t latency;             // connection events
+      uint32_t supervision_timeout; // ms
+    };
+
+    // static estimate of the RAM held by a single device, computed from the type sizes.
+    // Allocator overhead and the name strings are not included, the actual heap is reported by the scheduler
+    struct MemoryUsage
+    {
+      size_t device;         // the Device object, it embeds all of the below
+      size_t pipeline;       //   request pipeline
+      size_t command_queue;  //     queued commands
+      size_t in_flight;      //     in-flight and retried commands
+      size_t gatt_events;    //   GATT event queue
+      size_t key;            //   XXTEA key
+      size_t properties;     // property objects, including their decoded data
+      size_t data;           //   decoded data
+      size_t control_blocks; // shared_ptr control blocks of the properties and of the device itself, as allocated
+      uint8_t property_count;
+      uint8_t data_count;
+
+      size_t total() const { return this->device + this->properties + this->control_blocks; }
+    };
+
+    // phases of the current session, millis; 0 - the phase was not reached
+    struct SessionTimeline
+    {
+      uint32_t connect;   // connect() was requested
+      uint32_t open;      // ESP_GATTC_OPEN_EVT
+      uint32_t discovery; // ESP_GATTC_SEARCH_CMPL_EVT
+      uint32_t pin;       // PIN write was acknowledged
+      uint32_t response;  // the last read or write completion
+    };
+
+    const size_t SESSION_WINDOW = 16;   // sessions used for the percentiles
+    const size_t FAILURE_STATUSES = 4; // distinct GATT statuses counted separately
+
+    // statistics of the sessions since boot
+    struct SessionStats
+    {
+      uint16_t sessions;
+      uint16_t failures;        // failed sessions
+      uint32_t last_duration;   // ms, the last successful session
+      uint32_t last_discovery;  // ms, from connect() to the completed service discovery
+
+      uint32_t durations[SESSION_WINDOW]; // successful sessions, ms
+      uint8_t durations_count;
+      uint8_t durations_next;
+
+      // failed GATT operations by status
+      struct
+      {
+        esp_gatt_status_t status;
+        uint16_t count;
+      } statuses[FAILURE_STATUSES];
+      uint8_t statuses_count;
+      uint16_t other_statuses;
+
+      void add_duration(uint32_t duration);
+      void add_failure(esp_gatt_status_t status);
+      uint32_t percentile(uint8_t p) const;
+    };
+
+    // climate state, which was last published to Home Assistant
+    struct ClimateSnapshot
+    {
+      bool valid;
+      ClimateMode mode;
+      ClimateAction action;
+      float target_temperature;
+      float current_temperature;
+      float temperature_min;
+      float temperature_max;
+    };
+
     class Device : public MyComponent, public esphome::ble_client::BLEClientNode
     {
     public:
-      Device() : xxtea(make_shared<Xxtea>()){};
-
       void dump_config() override
       {
         LOG_CLIMATE("", "Danfoss Eco eTRV", this);
-        ESP_LOGCONFIG(TAG, "  MAC Address: %s", this->parent()->address_str().c_str());
+        if (this->address_ != 0)
+          ESP_LOGCONFIG(TAG, "  MAC Address: %s", format_address(this->address_).c_str());
+        else
+          ESP_LOGCONFIG(TAG, "  MAC Address: not provisioned yet");
+        if (this->pooled_)
+          ESP_LOGCONFIG(TAG, "  BLE Client: leased from the pool");
         LOG_SENSOR("", "Battery Level", this->battery_level_);
         LOG_SENSOR("", "Room Temperature", this->temperature_);
         LOG_BINARY_SENSOR("", "Problems", this->problems_);
+        LOG_SENSOR("", "Memory Usage (static estimate)", this->memory_usage_);
+        ESP_LOGCONFIG(TAG, "  Pipeline Depth: %d", this->pipeline_.depth());
+        ESP_LOGCONFIG(TAG, "  Request Timeout: %u ms", this->pipeline_.request_timeout());
+        ESP_LOGCONFIG(TAG, "  Max Retries: %d", this->pipeline_.max_retries());
+        ESP_LOGCONFIG(TAG, "  Command Queue: %d/%d used at peak, %d dropped", this->pipeline_.queue_high_watermark(), COMMAND_QUEUE_SIZE, this->pipeline_.dropped());
+        ESP_LOGCONFIG(TAG, "  GATT Event Queue: %d/%d used at peak, %d dropped", this->gatt_events_.high_watermark(), GATT_EVENT_QUEUE_SIZE, this->gatt_events_dropped_.load());
+        ESP_LOGCONFIG(TAG, "  Write Debounce: %u ms", this->write_debounce_);
+        ESP_LOGCONFIG(TAG, "  Max Silence: %u ms", this->max_silence_);
+        ESP_LOGCONFIG(TAG, "  Refresh Intervals: temperature=%u ms, settings=%u ms, errors=%u ms, battery=%u ms",
+                      this->refresh_intervals_[PROPERTY_TEMPERATURE], this->refresh_intervals_[PROPERTY_SETTINGS],
+                      this->refresh_intervals_[PROPERTY_ERRORS], this->refresh_intervals_[PROPERTY_BATTERY]);
+        if (this->adaptive_polling_)
+          ESP_LOGCONFIG(TAG, "  Adaptive Polling: %u - %u ms, threshold: %.1f°C", this->min_poll_interval_, this->max_poll_interval_, this->poll_threshold_);
+        if (this->keep_alive_ == KEEP_ALIVE_ALWAYS)
+          ESP_LOGCONFIG(TAG, "  Keep Alive: always");
+        else if (this->keep_alive_ > 0)
+          ESP_LOGCONFIG(TAG, "  Keep Alive: %u ms", this->keep_alive_);
+
+        auto &stats = this->session_stats_;
+        ESP_LOGCONFIG(TAG, "  Sessions: %d, failed: %d, last: %u ms, discovery: %u ms, p50: %u ms, p95: %u ms",
+                      stats.sessions, stats.failures, stats.last_duration, stats.last_discovery, stats.percentile(50), stats.percentile(95));
+        for (uint8_t i = 0; i < stats.statuses_count; i++)
+          ESP_LOGCONFIG(TAG, "  Failed GATT Operations: status=%#04x, count=%d", stats.statuses[i].status, stats.statuses[i].count);
+        if (stats.other_statuses > 0)
+          ESP_LOGCONFIG(TAG, "  Failed GATT Operations: other statuses, count=%d", stats.other_statuses);
+
+        auto usage = this->memory_usage();
+        ESP_LOGCONFIG(TAG, "  Memory (static estimate): %u bytes", usage.total());
+        ESP_LOGCONFIG(TAG, "    Device: %u bytes (request pipeline: %u, GATT event queue: %u, key: %u)", usage.device, usage.pipeline, usage.gatt_events, usage.key);
+        ESP_LOGCONFIG(TAG, "    Commands: %u queued, %u bytes, %d in flight and %d retried, %u bytes", COMMAND_QUEUE_SIZE, usage.command_queue,
+                      MAX_PIPELINE_DEPTH, MAX_PIPELINE_DEPTH, usage.in_flight);
+        ESP_LOGCONFIG(TAG, "    Properties: %d, %u bytes (%d decoded data: %u)", usage.property_count, usage.properties, usage.data_count, usage.data);
+        ESP_LOGCONFIG(TAG, "    shared_ptr Control Blocks: %d, %u bytes", usage.property_count + 1, usage.control_blocks);
       }
 
+      void call_setup() override;
       void setup() override;
       void loop() override;
       void update() override;
@@ -45,20 +189,88 @@ namespace esphome
 
       void set_secret_key(const string &);
       void set_pin_code(const string &);
+      void set_scheduler(ConnectionScheduler *scheduler) { this->scheduler_ = scheduler; }
+      // the MAC address is assigned at runtime by the scheduler, instead of being taken from ble_client
+      void set_slot(bool slot) { this->slot_ = slot; }
+      // ble_client is leased from the scheduler pool for the duration of a session
+      void set_pooled(bool pooled) { this->pooled_ = pooled; }
+      void set_mac_address(uint64_t address) { this->address_ = address; }
+      void add_setting(SettingEntity *entity) { this->setting_entities_[entity->setting()] = entity; }
+
+      void set_pipeline_depth(uint8_t depth) { this->pipeline_.set_depth(depth); }
+      void set_request_timeout(uint32_t request_timeout) { this->pipeline_.set_request_timeout(request_timeout); }
+      void set_max_retries(uint8_t max_retries) { this->pipeline_.set_max_retries(max_retries); }
+      void set_retry_backoff(uint32_t retry_backoff) { this->pipeline_.set_retry_backoff(retry_backoff); }
+
+      void set_write_debounce(uint32_t write_debounce) { this->write_debounce_ = write_debounce; }
+      void set_refresh_interval(PropertyId id, uint32_t refresh_interval) { this->refresh_intervals_[id] = refresh_interval; }
+      void set_adaptive_polling(uint32_t min_interval, uint32_t max_interval, float threshold)
+      {
+        this->adaptive_polling_ = true;
+        this->min_poll_interval_ = min_interval;
+        this->max_poll_interval_ = max_interval;
+        this->poll_threshold_ = threshold;
+      }
+      void set_keep_alive(uint32_t keep_alive) { this->keep_alive_ = keep_alive; }
+      void set_connection_params(uint32_t min_interval, uint32_t max_interval, uint16_t latency, uint32_t supervision_timeout)
+      {
+        this->conn_params_ = {min_interval, max_interval, latency, supervision_timeout};
+      }
+
+      uint64_t address() const { return this->address_; }
+      bool is_slot() const { return this->slot_; }
+      bool is_pooled() const { return this->pooled_; }
+      MemoryUsage memory_usage();
+      void bind(uint64_t address);
+
+      // changes of the settings are merged and written at once, after the write debounce window
+      void write_setting(SettingId id, float value);
+      void set_vacation(uint32_t from, uint32_t to);
+
+      // the session of this device is connected and the PIN was accepted.
+      // node_state is not used, a pooled device is not a node of the ble_client it has leased
+      bool is_established() { return this->session_ && this->pin_accepted_; }
 
     protected:
+      friend class ConnectionScheduler;
+
       void control(const ClimateCall &call) override;
 
       void connect();
       void disconnect();
+      PropertyMask due_properties();
+      void read_state(PropertyMask properties);
+      void schedule_settings_write();
+      void flush_writes();
+      void publish_changes();
+      void publish_climate();
+      void publish_settings();
+      float get_setting(SettingId id);
+      void adapt_poll_interval();
+
+      void queue_handles(esp_gatt_status_t status);
+      void on_search_complete(GattEvent &);
+      void load_handles();
+      void save_handles(HandleCacheValue &);
+      HandleCacheValue get_handles();
+      array<shared_ptr<DeviceProperty>, CACHED_HANDLES_COUNT> cached_properties();
+
+      void update_connection_params(esp_bd_addr_t remote_bda);
+      bool is_kept_alive();
 
       void write_pin();
-      void on_write_pin(esp_ble_gattc_cb_param_t::gattc_write_evt_param);
 
-      void on_read(esp_ble_gattc_cb_param_t::gattc_read_char_evt_param);
-      void on_write(esp_ble_gattc_cb_param_t::gattc_write_evt_param);
+      void queue_event(esp_gattc_cb_event_t event, esp_gatt_status_t status, uint16_t handle, const uint8_t *value, uint16_t value_len);
+      void process_events();
+
+      void on_write_pin(GattEvent &);
+      void on_read(GattEvent &);
+      void on_read_multiple(GattEvent &);
+      void on_write(GattEvent &);
+
+      void finish_session(bool success);
 
-      shared_ptr<Xxtea> xxtea;
+      XxteaKey xxtea;
 
       shared_ptr<WritableProperty> p_pin{nullptr};
       shared_ptr<BatteryProperty> p_battery{nullptr};
@@ -67,14 +279,63 @@ namespace esphome
       shared_ptr<ErrorsProperty> p_errors{nullptr};
       shared_ptr<SecretKeyProperty> p_secret_key{nullptr};
 
-      set<shared_ptr<DeviceProperty>> properties{nullptr};
+      array<shared_ptr<DeviceProperty>, PROPERTY_COUNT> properties;
 
     private:
+      ConnectionScheduler *scheduler_{nullptr};
+      uint64_t address_ = 0; // 0 - slot, which is not provisioned yet
+      bool slot_ = false;
+      bool pooled_ = false;
+      // ble_client might be shared, its events are only handled during the own session.
+      // Set by the main loop, read by the BT task
+      atomic<bool> session_{false};
+      ESPPreferenceObject address_pref_;
       ESPPreferenceObject secret_pref_;
+      ESPPreferenceObject handles_pref_;
+      bool handles_cached_ = false;
       uint32_t pin_code_ = 0;
 
-      uint8_t request_counter_ = 0;
-      CommandQueue commands_;
+      RequestPipeline pipeline_;
+      size_t shared_blocks_ = 0; // bytes of the shared_ptr blocks allocated by setup()
+
+      array<SettingEntity *, SETTING_COUNT> setting_entities_{};
+
+      SessionTimeline timeline_ = {0};
+      SessionStats session_stats_ = {0};
+
+      RingBuffer<GattEvent, GATT_EVENT_QUEUE_SIZE> gatt_events_;
+      atomic<uint16_t> gatt_events_dropped_{0};
+
+      uint16_t mtu_ = ESP_GATT_DEF_BLE_MTU_SIZE;
+      bool pin_requested_ = false;
+      bool pin_accepted_ = false;
+      uint32_t pin_written_at_ = 0;
+      uint8_t pin_attempts_ = 0;
+      bool read_secret_key_ = false;
+
+      uint32_t keep_alive_ = 0; // idle window after control(), 0 - disconnect as soon as all requests are completed
+      uint32_t keep_alive_until_ = 0;
+      ConnectionParams conn_params_ = {10, 30, 0, 4000};
+
+      uint32_t refresh_intervals_[PROPERTY_COUNT] = {0};
+
+      uint32_t last_publish_ = 0; // millis of the last climate state publish
+      bool state_read_ = false; // a value was read since the state was last published
+      ClimateSnapshot published_ = {false};
+
+      // with adaptive polling the next poll is scheduled once the state is read, update_interval is only the initial interval
+      bool adaptive_polling_ = false;
+      uint32_t min_poll_interval_ = 0;
+      uint32_t max_poll_interval_ = 0;
+      float poll_threshold_ = 0.5;      // °C
+      uint32_t poll_interval_ = 0;      // current interval
+      bool poll_pending_ = false;       // the state was requested in the current session
+      bool fast_poll_ = false;          // the device was changed from HA in the current session
+      float last_room_temperature_ = NAN;
+
+      uint32_t write_debounce_ = 1000;
+      uint8_t pending_writes_ = 0;      // PendingWrite flags
+      PropertyMask confirm_writes_ = 0; // written properties, which are read back once all writes of the session have completed
     };
 
   } // namespace danfoss_eco
@@ -1,9 +1,10 @@
 #pragma once
 
+#include "esphome/components/climate/climate_mode.h"
 #include "esphome/core/log.h"
 
 #include "helpers.h"
-#include "xxtea.h"
+#include "schema.h"
 
 namespace esphome
 {
@@ -12,48 +13,66 @@ namespace esphome
         using namespace std;
         using namespace climate;
 
+        // Decoded characteristic values. Each property owns a single instance, which is decoded in place on every read,
+        // so polling does not allocate. Values are plain (decrypted) bytes, encryption is done by the property.
+        // Field layout is declared once in schema.h.
         struct DeviceData
         {
-            uint16_t length;
-
-            DeviceData(uint16_t l, shared_ptr<Xxtea> &xxtea) : length(l), xxtea_(xxtea) {}
-            virtual ~DeviceData()
-            {
-            }
-
-        protected:
-            shared_ptr<Xxtea> xxtea_;
+            bool valid = false; // false until the value was read from the device at least once
         };
 
-        struct WritableData : public DeviceData
+        struct TemperatureData : public DeviceData
         {
-            WritableData(uint16_t l, shared_ptr<Xxtea> &xxtea) : DeviceData(8, xxtea) {}
-            virtual void pack(uint8_t *) = 0;
-        };
+            using Schema = TemperatureSchema;
+            static const uint16_t LENGTH = Schema::LENGTH;
 
-        struct TemperatureData : public WritableData
-        {
+            // decoded from the bytes, read-only - use set_target_temperature() to change it
             float target_temperature;
             float room_temperature;
 
-            TemperatureData(shared_ptr<Xxtea> &xxtea, uint8_t *raw_data, uint16_t value_len) : WritableData(8, xxtea)
+            // like SettingsData, the local target survives reads until the device has acknowledged it
+            void set_target_temperature(float temperature)
             {
-                uint8_t *temperatures = decrypt(this->xxtea_, raw_data, value_len);
-                this->target_temperature = temperatures[0] / 2.0f;
-                this->room_temperature = temperatures[1] / 2.0f;
+                this->target_temperature = temperature;
+                this->revision_++;
             }
 
-            void pack(uint8_t *buff)
+            void decode(const uint8_t *temperatures)
             {
-                buff[0] = (uint8_t)(target_temperature * 2);
-                buff[1] = (uint8_t)(room_temperature * 2);
+                if (!this->has_changes())
+                    this->target_temperature = Schema::target_temperature::decode(temperatures);
+                this->room_temperature = Schema::room_temperature::decode(temperatures);
+                this->valid = true;
+            }
 
-                encrypt(this->xxtea_, buff, length);
+            void pack(uint8_t *buff)
+            {
+                Schema::target_temperature::encode(buff, this->target_temperature);
+                Schema::room_temperature::encode(buff, this->room_temperature);
+                this->packed_revision_ = this->revision_;
             }
+
+            bool has_changes() const { return this->revision_ != this->committed_revision_; }
+
+            // the packed value was acknowledged by the device, a change made after it was packed is still pending
+            void commit() { this->committed_revision_ = this->packed_revision_; }
+
+            // the change could not be written, the next read restores the device value
+            void discard_changes() { this->committed_revision_ = this->revision_; }
+
+        private:
+            uint16_t revision_ = 0; // incremented on every local change
+            uint16_t packed_revision_ = 0;
+            uint16_t committed_revision_ = 0;
         };
 
-        struct SettingsData : public WritableData
+        // The value is written back as a whole, so the raw bytes are the state: fields, which are not decoded, are written
+        // back as they were read. Local changes are tracked by a mask and survive reads until the device has acknowledged them.
+        struct SettingsData : public DeviceData
         {
+            using Schema = SettingsSchema;
+            static const uint16_t LENGTH = Schema::LENGTH;
+
             enum DeviceMode
             {
                 MANUAL = 0,
@@ -62,20 +81,33 @@ namespace esphome
                 HOLD = 5
             };
 
-            bool get_adaptable_regulation() { return parse_bit(this->settings_[0], 0); }
-            bool get_vertical_intallation() { return parse_bit(this->settings_[0], 2); }
-            bool get_display_flip() { return parse_bit(this->settings_[0], 3); }
-            bool get_slow_regulation() { return parse_bit(this->settings_[0], 4); }
-            bool get_valve_installed() { return parse_bit(this->settings_[0], 6); }
-            bool get_lock_control() { return parse_bit(this->settings_[0], 7); }
-
-            void set_adaptable_regulation(bool state) { set_bit(this->settings_[0], 0, state); }
-            void set_vertical_intallation(bool state) { set_bit(this->settings_[0], 2, state); }
-            void set_display_flip(bool state) { set_bit(this->settings_[0], 3, state); }
-            void set_slow_regulation(bool state) { set_bit(this->settings_[0], 4, state); }
-            void set_valve_installed(bool state) { set_bit(this->settings_[0], 6, state); }
-            void set_lock_control(bool state) { set_bit(this->settings_[0], 7, state); }
+            bool get_adaptable_regulation() const { return Schema::adaptable_regulation::decode(this->settings_); }
+            bool get_vertical_intallation() const { return Schema::vertical_installation::decode(this->settings_); }
+            bool get_display_flip() const { return Schema::display_flip::decode(this->settings_); }
+            bool get_slow_regulation() const { return Schema::slow_regulation::decode(this->settings_); }
+            bool get_valve_installed() const { return Schema::valve_installed::decode(this->settings_); }
+            bool get_lock_control() const { return Schema::lock_control::decode(this->settings_); }
+
+            void set_adaptable_regulation(bool state) { this->set<Schema::adaptable_regulation>(state); }
+            void set_vertical_intallation(bool state) { this->set<Schema::vertical_installation>(state); }
+            void set_display_flip(bool state) { this->set<Schema::display_flip>(state); }
+            void set_slow_regulation(bool state) { this->set<Schema::slow_regulation>(state); }
+            void set_valve_installed(bool state) { this->set<Schema::valve_installed>(state); }
+            void set_lock_control(bool state) { this->set<Schema::lock_control>(state); }
+
+            void set_temperature_min(float temperature) { this->set<Schema::temperature_min>(temperature); }
+            void set_temperature_max(float temperature) { this->set<Schema::temperature_max>(temperature); }
+            void set_frost_protection_temperature(float temperature) { this->set<Schema::frost_protection_temperature>(temperature); }
+            void set_vacation_temperature(float temperature) { this->set<Schema::vacation_temperature>(temperature); }
+            void set_vacation(uint32_t from, uint32_t to)
+            {
+                this->set<Schema::vacation_from>(from);
+                this->set<Schema::vacation_to>(to);
+            }
+            // only HEAT and AUTO are supported by the climate, VACATION and HOLD are kept as they are, unless the mode is set
+            void set_device_mode(ClimateMode mode) { this->set<Schema::device_mode>(mode == ClimateMode::CLIMATE_MODE_AUTO ? DeviceMode::SCHEDULED : DeviceMode::MANUAL); }
 
+            // decoded from the bytes, read-only - use the setters to change them
             ClimateMode device_mode;
 
             float temperature_min;
@@ -86,26 +118,17 @@ namespace esphome
             time_t vacation_from; // utc
             time_t vacation_to;   // utc
 
-            SettingsData(shared_ptr<Xxtea> &xxtea, uint8_t *raw_data, uint16_t value_len) : WritableData(16, xxtea)
+            void decode(const uint8_t *settings)
             {
-                uint8_t *settings = decrypt(this->xxtea_, raw_data, value_len);
-
-                this->settings_ = (uint8_t *)malloc(length);
-                memcpy(this->settings_, (const char *)settings, length);
-
-                this->temperature_min = settings[1] / 2.0f;
-                this->temperature_max = settings[2] / 2.0f;
-                this->frost_protection_temperature = settings[3] / 2.0f;
-                this->device_mode = to_climate_mode((DeviceMode)settings[4]);
-                this->vacation_temperature = settings[5] / 2.0f;
+                // changes, which were not acknowledged by the device yet, take precedence over the read value
+                for (uint16_t i = 0; i < LENGTH; i++)
+                    this->settings_[i] = (settings[i] & ~this->changed_[i]) | (this->settings_[i] & this->changed_[i]);
 
-                this->vacation_from = parse_int(settings, 6);
-                this->vacation_to = parse_int(settings, 10);
+                this->decode_fields();
+                this->valid = true;
             }
 
-            ~SettingsData() { free(this->settings_); }
-
-            ClimateMode to_climate_mode(DeviceMode mode)
+            static ClimateMode to_climate_mode(DeviceMode mode)
             {
                 switch (mode)
                 {
@@ -125,44 +148,73 @@ namespace esphome
 
             void pack(uint8_t *buff)
             {
-                memcpy(buff, (const char *)this->settings_, length);
+                memcpy(buff, this->settings_, LENGTH);
+                this->packed_revision_ = this->revision_;
+            }
 
-                buff[1] = (uint8_t)(this->temperature_min * 2);
-                buff[2] = (uint8_t)(this->temperature_max * 2);
-                buff[3] = (uint8_t)(this->frost_protection_temperature * 2);
-                if (this->device_mode == ClimateMode::CLIMATE_MODE_AUTO)
-                    buff[4] = DeviceMode::SCHEDULED;
-                else
-                    buff[4] = DeviceMode::MANUAL;
-                buff[5] = (uint8_t)(this->vacation_temperature * 2);
+            bool has_changes() const { return this->revision_ != this->committed_revision_; }
 
-                write_int(buff, 6, this->vacation_from);
-                write_int(buff, 10, this->vacation_to);
+            // the packed value was acknowledged by the device, changes made after it was packed are still pending
+            void commit()
+            {
+                this->committed_revision_ = this->packed_revision_;
+                if (!this->has_changes())
+                    memset(this->changed_, 0, LENGTH);
+            }
 
-                encrypt(this->xxtea_, buff, length);
+            // the changes could not be written, the next read restores the device value
+            void discard_changes()
+            {
+                this->committed_revision_ = this->revision_;
+                memset(this->changed_, 0, LENGTH);
             }
 
         private:
-            uint8_t *settings_;
+            template <class Field, class T>
+            void set(T value)
+            {
+                Field::encode(this->settings_, value);
+                Field::mark(this->changed_);
+                this->revision_++;
+                this->decode_fields();
+            }
+
+            void decode_fields()
+            {
+                this->temperature_min = Schema::temperature_min::decode(this->settings_);
+                this->temperature_max = Schema::temperature_max::decode(this->settings_);
+                this->frost_protection_temperature = Schema::frost_protection_temperature::decode(this->settings_);
+                this->device_mode = to_climate_mode((DeviceMode)Schema::device_mode::decode(this->settings_));
+                this->vacation_temperature = Schema::vacation_temperature::decode(this->settings_);
+
+                this->vacation_from = Schema::vacation_from::decode(this->settings_);
+                this->vacation_to = Schema::vacation_to::decode(this->settings_);
+            }
+
+            uint8_t settings_[LENGTH]{0};
+            uint8_t changed_[LENGTH]{0}; // bits changed locally
+            uint16_t revision_ = 0;       // incremented on every local change
+            uint16_t packed_revision_ = 0;
+            uint16_t committed_revision_ = 0;
         };
 
         struct ErrorsData : public DeviceData
         {
+            using Schema = ErrorsSchema;
+            static const uint16_t LENGTH = Schema::LENGTH;
+
             bool E9_VALVE_DOES_NOT_CLOSE;
             bool E10_INVALID_TIME;
             bool E14_LOW_BATTERY;
             bool E15_VERY_LOW_BATTERY;
 
-            ErrorsData(shared_ptr<Xxtea> &xxtea, uint8_t *raw_data, uint16_t value_len) : DeviceData(8, xxtea)
+            void decode(const uint8_t *value)
             {
-                // unsigned short error;
-                // unsigned char padding[6];
-                uint16_t errors = parse_short(decrypt(this->xxtea_, raw_data, value_len), 0);
-
-                E9_VALVE_DOES_NOT_CLOSE = parse_bit(errors, 8);
-                E10_INVALID_TIME = parse_bit(errors, 9);
-                E14_LOW_BATTERY = parse_bit(errors, 13);
-                E15_VERY_LOW_BATTERY = parse_bit(errors, 14);
+                E9_VALVE_DOES_NOT_CLOSE = Schema::valve_does_not_close::decode(value);
+                E10_INVALID_TIME = Schema::invalid_time::decode(value);
+                E14_LOW_BATTERY = Schema::low_battery::decode(value);
+                E15_VERY_LOW_BATTERY = Schema::very_low_battery::decode(value);
+                this->valid = true;
             }
         };
 
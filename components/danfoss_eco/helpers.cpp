@@ -3,7 +3,6 @@
 
 #include "helpers.h"
 
-#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
 namespace esphome
 {
     namespace danfoss_eco
@@ -27,76 +26,36 @@ namespace esphome
             return {};
         }
 
-        void parse_hex_str(const char *data, size_t str_len, uint8_t *buff)
+        bool parse_hex_str(const char *data, size_t str_len, uint8_t *buff)
         {
-            size_t len = str_len / 2;
-            for (size_t i = 0; i < len; i++)
-                buff[i] = (parse_hex(data[i * 2]).value() << 4) | parse_hex(data[i * 2 + 1]).value();
-        }
-
-        uint32_t parse_int(uint8_t *data, int start_pos)
-        {
-            return int(data[start_pos] << 24 | data[start_pos + 1] << 16 | data[start_pos + 2] << 8 | data[start_pos + 3]);
-        }
-
-        uint16_t parse_short(uint8_t *data, int start_pos)
-        {
-            return short(data[start_pos] << 8 | data[start_pos + 1]);
-        }
-
-        void write_int(uint8_t *data, int start_pos, int value)
-        {
-            data[start_pos] = value >> 24;
-            data[start_pos + 1] = value >> 16;
-            data[start_pos + 2] = value >> 8;
-            data[start_pos + 3] = value;
-        }
+            if (str_len % 2 != 0)
+                return false;
 
-        bool parse_bit(uint8_t data, int pos) { return (data & (1 << pos)) >> pos; }
-
-        bool parse_bit(uint16_t data, int pos) { return (data & (1 << pos)) >> pos; }
-
-        void set_bit(uint8_t data, int pos, bool value)
-        {
-            data ^= (-value ^ data) & (1UL << pos);
-        }
-
-        void reverse_chunks(uint8_t *data, int len, uint8_t *reversed_buff)
-        {
-            for (int i = 0; i < len; i += 4)
+            for (size_t i = 0; i < str_len / 2; i++)
             {
-                int l = MIN(4, len - i); // limit for a chunk, 4 or what's left
-                for (int j = 0; j < l; j++)
-                {
-                    reversed_buff[i + j] = data[i + (l - 1 - j)];
-                }
+                auto high = parse_hex(data[i * 2]);
+                auto low = parse_hex(data[i * 2 + 1]);
+                if (!high.has_value() || !low.has_value())
+                    return false;
+                buff[i] = (*high << 4) | *low;
             }
+            return true;
         }
 
-        uint8_t *encrypt(shared_ptr<Xxtea> &xxtea, uint8_t *value, uint16_t value_len)
+        bool encrypt(const XxteaKey &key, uint8_t *value, uint16_t value_len)
         {
-            uint8_t buffer[value_len], enc_buff[value_len];
-            reverse_chunks(value, value_len, buffer);
-
-            auto xxtea_status = xxtea->encrypt(buffer, value_len, enc_buff, (size_t *)&value_len);
+            auto xxtea_status = xxtea_encrypt(key, value, value_len);
             if (xxtea_status != XXTEA_STATUS_SUCCESS)
                 ESP_LOGW(TAG, "xxtea_encrypt failed, status=%d", xxtea_status);
-            else
-                reverse_chunks(enc_buff, value_len, value);
-            return value;
+            return xxtea_status == XXTEA_STATUS_SUCCESS;
         }
 
-        uint8_t *decrypt(shared_ptr<Xxtea> &xxtea, uint8_t *value, uint16_t value_len)
+        bool decrypt(const XxteaKey &key, uint8_t *value, uint16_t value_len)
         {
-            uint8_t buffer[value_len];
-            reverse_chunks(value, value_len, buffer);
-
-            auto xxtea_status = xxtea->decrypt(buffer, value_len);
+            auto xxtea_status = xxtea_decrypt(key, value, value_len);
             if (xxtea_status != XXTEA_STATUS_SUCCESS)
                 ESP_LOGW(TAG, "xxtea_decrypt failed, status=%d", xxtea_status);
-            else
-                reverse_chunks(buffer, value_len, value);
-            return value;
+            return xxtea_status == XXTEA_STATUS_SUCCESS;
         }
 
         void copy_address(uint64_t mac, esp_bd_addr_t bd_addr)
@@ -109,5 +68,15 @@ namespace esphome
             bd_addr[5] = (mac >> 0) & 0xFF;
         }
 
+        string format_address(uint64_t mac)
+        {
+            // same format as ble_client address_str(), it is a part of the preference keys
+            char buff[18];
+            snprintf(buff, sizeof(buff), "%02X:%02X:%02X:%02X:%02X:%02X",
+                     (uint8_t)(mac >> 40), (uint8_t)(mac >> 32), (uint8_t)(mac >> 24),
+                     (uint8_t)(mac >> 16), (uint8_t)(mac >> 8), (uint8_t)(mac >> 0));
+            return buff;
+        }
+
     }
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 #include <esp_bt_defs.h>
 
+#include <cmath>
+#include <string>
+
 namespace esphome
 {
     namespace danfoss_eco
@@ -13,20 +16,19 @@ namespace esphome
         const char *const TAG = "danfoss_eco";
 
         void encode_hex(const uint8_t *data, size_t len, char *buff);
-        void parse_hex_str(const char *data, size_t str_len, uint8_t *buff);
-        uint32_t parse_int(uint8_t *data, int start_pos);
-        uint16_t parse_short(uint8_t *data, int start_pos);
-        void write_int(uint8_t *data, int start_pos, int value);
-
-        bool parse_bit(uint8_t data, int pos);
-        bool parse_bit(uint16_t data, int pos);
-        void set_bit(uint8_t data, int pos, bool value);
+        // returns false, if the string has an odd length or a character, which is not a hex digit
+        bool parse_hex_str(const char *data, size_t str_len, uint8_t *buff);
 
-        void reverse_chunks(uint8_t *data, int len, uint8_t *reversed_buff);
+        // in place, false if the key is not set or the length is not supported
+        bool encrypt(const XxteaKey &key, uint8_t *value, uint16_t value_len);
+        bool decrypt(const XxteaKey &key, uint8_t *value, uint16_t value_len);
 
-        uint8_t *encrypt(shared_ptr<Xxtea> &xxtea, uint8_t *value, uint16_t value_len);
-        uint8_t *decrypt(shared_ptr<Xxtea> &xxtea, uint8_t *value, uint16_t value_len);
+        // NaN marks a value, which is not known yet: two unknown values are the same
+        inline bool same_value(float a, float b) { return a == b || (isnan(a) && isnan(b)); }
+        // an unchanged value is re-published, once it was not published for max_silence, 0 - on every poll
+        inline bool heartbeat_due(uint32_t now, uint32_t last_publish, uint32_t max_silence) { return max_silence == 0 || now - last_publish >= max_silence; }
 
         void copy_address(uint64_t, esp_bd_addr_t);
+        string format_address(uint64_t);
     }
 }
\ No newline at end of file
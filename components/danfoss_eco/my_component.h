@@ -1,6 +1,7 @@
 #pragma once
 
 #include "esphome/core/component.h"
+#include "esphome/core/hal.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/binary_sensor/binary_sensor.h"
 #include "esphome/components/climate/climate.h"
@@ -37,17 +38,62 @@ namespace esphome
             void set_battery_level(Sensor *battery_level) { battery_level_ = battery_level; }
             void set_temperature(Sensor *temperature) { temperature_ = temperature; }
             void set_problems(BinarySensor *problems) { problems_ = problems; }
+            void set_memory_usage(Sensor *memory_usage) { memory_usage_ = memory_usage; }
+            void set_session_duration(Sensor *session_duration) { session_duration_ = session_duration; }
+            void set_discovery_time(Sensor *discovery_time) { discovery_time_ = discovery_time; }
+            void set_session_duration_p50(Sensor *session_duration_p50) { session_duration_p50_ = session_duration_p50; }
+            void set_session_duration_p95(Sensor *session_duration_p95) { session_duration_p95_ = session_duration_p95; }
+            void set_session_failures(Sensor *session_failures) { session_failures_ = session_failures; }
 
-            Sensor *battery_level() { return this->battery_level_; }
-            Sensor *temperature() { return this->temperature_; }
-            BinarySensor *problems() { return this->problems_; }
+            void set_max_silence(uint32_t max_silence) { this->max_silence_ = max_silence; }
+
+            Sensor *memory_usage_sensor() { return this->memory_usage_; }
 
             virtual void set_secret_key(uint8_t *, bool) = 0;
 
+            void publish_battery_level(float state) { this->publish_sensor(this->battery_level_, this->battery_level_published_, state); }
+            void publish_temperature(float state) { this->publish_sensor(this->temperature_, this->temperature_published_, state); }
+            void publish_problems(bool state) { this->publish_binary_sensor(this->problems_, this->problems_published_, state); }
+
         protected:
+            // sensors are published only when the value has changed, or when it was not published for max_silence
+            void publish_sensor(Sensor *sensor, uint32_t &last_publish, float state)
+            {
+                uint32_t now = millis();
+                // raw_state is compared, as filters may change the published state
+                if (sensor != nullptr && (!sensor->has_state() || !same_value(sensor->raw_state, state) || heartbeat_due(now, last_publish, this->max_silence_)))
+                {
+                    sensor->publish_state(state);
+                    last_publish = now;
+                }
+            }
+
+            void publish_binary_sensor(BinarySensor *sensor, uint32_t &last_publish, bool state)
+            {
+                uint32_t now = millis();
+                if (sensor != nullptr && (!sensor->has_state() || !same_value(sensor->state, state) || heartbeat_due(now, last_publish, this->max_silence_)))
+                {
+                    sensor->publish_state(state);
+                    last_publish = now;
+                }
+            }
+
+            uint32_t max_silence_ = 3600000; // unchanged values are published at least this often, 0 - publish on every poll
+
             Sensor *battery_level_{nullptr};
             Sensor *temperature_{nullptr};
             BinarySensor *problems_{nullptr};
+            Sensor *memory_usage_{nullptr};
+            Sensor *session_duration_{nullptr};
+            Sensor *discovery_time_{nullptr};
+            Sensor *session_duration_p50_{nullptr};
+            Sensor *session_duration_p95_{nullptr};
+            Sensor *session_failures_{nullptr};
+
+            // millis of the last publish of every sensor, which is published only when its value has changed
+            uint32_t battery_level_published_ = 0;
+            uint32_t temperature_published_ = 0;
+            uint32_t problems_published_ = 0;
         };
 
     } // namespace danfoss_eco
@@ -10,18 +10,42 @@ namespace esphome
 {
     namespace danfoss_eco
     {
-        bool DeviceProperty::init_handle(BLEClient *client)
+        uint16_t DeviceProperty::find_handle(BLEClient *client)
         {
             ESP_LOGV(TAG, "[%s] resolving handler for service=%s, characteristic=%s", this->component_->get_name().c_str(), this->service_uuid.to_string().c_str(), this->characteristic_uuid.to_string().c_str());
             auto chr = client->get_characteristic(this->service_uuid, this->characteristic_uuid);
             if (chr == nullptr)
             {
                 ESP_LOGW(TAG, "[%s] characteristic uuid=%s not found", this->component_->get_name().c_str(), this->characteristic_uuid.to_string().c_str());
-                return false;
+                return INVALID_HANDLE;
             }
 
-            this->handle = chr->handle;
-            return true;
+            return chr->handle;
+        }
+
+        bool DeviceProperty::check_length(uint16_t value_len)
+        {
+            if (value_len == this->value_length)
+                return true;
+
+            ESP_LOGW(TAG, "[%s] unexpected value length: handle=%#04x, length=%d (expected %d)", this->component_->get_name().c_str(), this->handle, value_len, this->value_length);
+            return false;
+        }
+
+        bool DeviceProperty::read_value(uint8_t *value, uint16_t value_len)
+        {
+            if (!this->check_length(value_len))
+                return false;
+            return !this->encrypted || decrypt(this->xxtea_, value, value_len);
+        }
+
+        bool DeviceProperty::is_due(uint32_t now, uint32_t next_poll)
+        {
+            if (!this->read_once_ || this->refresh_interval == 0)
+                return true;
+
+            // value, which would be too old by the next poll, is read now
+            return now - this->last_read_ + next_poll > this->refresh_interval + this->staleness_budget;
         }
 
         bool DeviceProperty::read_request(BLEClient *client)
@@ -36,6 +60,22 @@ namespace esphome
             return status == ESP_OK;
         }
 
+        bool read_multiple_request(BLEClient *client, const uint16_t *handles, uint8_t count)
+        {
+            esp_gattc_multi_t read_multi;
+            read_multi.num_attr = count;
+            memcpy(read_multi.handles, handles, count * sizeof(uint16_t));
+
+            auto status = esp_ble_gattc_read_multiple(client->get_gattc_if(),
+                                                      client->get_conn_id(),
+                                                      &read_multi,
+                                                      ESP_GATT_AUTH_REQ_NONE);
+            if (status != ESP_OK)
+                ESP_LOGW(TAG, "esp_ble_gattc_read_multiple failed, num_attr=%d, status=%01x", read_multi.num_attr, status);
+
+            return status == ESP_OK;
+        }
+
         bool WritableProperty::write_request(BLEClient *client, uint8_t *data, uint16_t data_len)
         {
             ESP_LOGD(TAG, "[%s] write_request: handle=%#04x, data=%s", this->component_->get_name().c_str(), this->handle, format_hex_pretty(data, data_len).c_str());
@@ -55,41 +95,65 @@ namespace esphome
 
         bool WritableProperty::write_request(BLEClient *client)
         {
-            WritableData *writableData = static_cast<WritableData *>(this->data.get());
-            uint8_t buff[this->data->length]{0};
-            writableData->pack(buff);
-            return this->write_request(client, buff, sizeof(buff));
+            if (this->value_length > MAX_VALUE_LENGTH)
+            {
+                ESP_LOGE(TAG, "[%s] value is too long to be written: handle=%#04x, length=%d", this->component_->get_name().c_str(), this->handle, this->value_length);
+                return false;
+            }
+
+            uint8_t buff[MAX_VALUE_LENGTH] = {0};
+            this->pack(buff);
+
+            // a plain value of an encrypted characteristic must never reach the device
+            if (this->encrypted && !encrypt(this->xxtea_, buff, this->value_length))
+                return false;
+            return this->write_request(client, buff, this->value_length);
         }
 
-        void BatteryProperty::update_state(uint8_t *value, uint16_t value_len)
+        bool BatteryProperty::update_state(uint8_t *value, uint16_t value_len)
         {
-            uint8_t battery_level = value[0];
+            if (!this->read_value(value, value_len))
+                return false;
+
+            uint8_t battery_level = BatterySchema::battery_level::decode(value);
+            if (battery_level > 100)
+            {
+                ESP_LOGW(TAG, "[%s] unexpected battery level: %d", this->component_->get_name().c_str(), battery_level);
+                return false;
+            }
+
             ESP_LOGD(TAG, "[%s] battery level: %d %%", this->component_->get_name().c_str(), battery_level);
-            if (this->component_->battery_level() != nullptr)
-                this->component_->battery_level()->publish_state(battery_level);
+            this->component_->publish_battery_level(battery_level);
+            return true;
         }
 
-        void TemperatureProperty::update_state(uint8_t *value, uint16_t value_len)
+        bool TemperatureProperty::update_state(uint8_t *value, uint16_t value_len)
         {
-            auto t_data = new TemperatureData(this->xxtea_, value, value_len);
-            this->data.reset(t_data);
+            if (!this->read_value(value, value_len))
+                return false;
+
+            auto t_data = &this->data;
+            t_data->decode(value);
 
             ESP_LOGD(TAG, "[%s] Current room temperature: %2.1f°C, Set point temperature: %2.1f°C", this->component_->get_name().c_str(), t_data->room_temperature, t_data->target_temperature);
-            if (this->component_->temperature() != nullptr)
-                this->component_->temperature()->publish_state(t_data->room_temperature);
+            this->component_->publish_temperature(t_data->room_temperature);
 
-            // apply read configuration to the component
+            // apply read configuration to the component, climate state is published once the session is completed.
+            // target_temperature is the pending one, until the device has acknowledged it
             // TODO component->action should consider "open window detection" feature of Danfoss Eco
             this->component_->action = (t_data->room_temperature > t_data->target_temperature) ? climate::ClimateAction::CLIMATE_ACTION_IDLE : climate::ClimateAction::CLIMATE_ACTION_HEATING;
             this->component_->target_temperature = t_data->target_temperature;
             this->component_->current_temperature = t_data->room_temperature;
-            this->component_->publish_state();
+            return true;
         }
 
-        void SettingsProperty::update_state(uint8_t *value, uint16_t value_len)
+        bool SettingsProperty::update_state(uint8_t *value, uint16_t value_len)
         {
-            auto s_data = new SettingsData(this->xxtea_, value, value_len);
-            this->data.reset(s_data);
+            if (!this->read_value(value, value_len))
+                return false;
+
+            auto s_data = &this->data;
+            s_data->decode(value);
 
             const char *name = this->component_->get_name().c_str();
             ESP_LOGD(TAG, "[%s] adaptable_regulation: %d", name, s_data->get_adaptable_regulation());
@@ -106,17 +170,20 @@ namespace esphome
             ESP_LOGD(TAG, "[%s] vacation_from: %d", name, (int)s_data->vacation_from);
             ESP_LOGD(TAG, "[%s] vacation_to: %d", name, (int)s_data->vacation_to);
 
-            // apply read configuration to the component
+            // apply read configuration to the component, climate state is published once the session is completed
             this->component_->mode = s_data->device_mode;
             this->component_->set_visual_min_temperature_override(s_data->temperature_min);
             this->component_->set_visual_max_temperature_override(s_data->temperature_max);
-            this->component_->publish_state();
+            return true;
         }
 
-        void ErrorsProperty::update_state(uint8_t *value, uint16_t value_len)
+        bool ErrorsProperty::update_state(uint8_t *value, uint16_t value_len)
         {
-            auto e_data = new ErrorsData(this->xxtea_, value, value_len);
-            this->data.reset(e_data);
+            if (!this->read_value(value, value_len))
+                return false;
+
+            auto e_data = &this->data;
+            e_data->decode(value);
 
             const char *name = this->component_->get_name().c_str();
 
@@ -126,37 +193,30 @@ namespace esphome
             ESP_LOGD(TAG, "[%s] E15_VERY_LOW_BATTERY: %d", name, e_data->E15_VERY_LOW_BATTERY);
 
             // TODO: it would be great to add actual error code to binary_sensor state attributes, but I'm not sure how to achieve that
-            if (this->component_->problems() != nullptr)
-                this->component_->problems()->publish_state(e_data->E9_VALVE_DOES_NOT_CLOSE || e_data->E10_INVALID_TIME || e_data->E14_LOW_BATTERY || e_data->E15_VERY_LOW_BATTERY);
+            this->component_->publish_problems(e_data->E9_VALVE_DOES_NOT_CLOSE || e_data->E10_INVALID_TIME || e_data->E14_LOW_BATTERY || e_data->E15_VERY_LOW_BATTERY);
+            return true;
         }
 
-        bool SecretKeyProperty::init_handle(BLEClient *client)
+        uint16_t SecretKeyProperty::find_handle(BLEClient *client)
         {
-            if (this->xxtea_->status() != XXTEA_STATUS_NOT_INITIALIZED)
+            if (this->xxtea_.status() != XXTEA_STATUS_NOT_INITIALIZED)
             {
                 ESP_LOGD(TAG, "[%s] xxtea is initialized, will not request a read of secret_key", this->component_->get_name().c_str());
-                return true;
+                return INVALID_HANDLE;
             }
 
             auto chr = client->get_characteristic(this->service_uuid, this->characteristic_uuid);
             if (chr != nullptr)
-            {
-                this->handle = chr->handle;
-                return true;
-            }
+                return chr->handle;
 
             ESP_LOGW(TAG, "[%s] Danfoss Eco hardware button was not pressed, unable to read the secret key", this->component_->get_name().c_str());
-            this->handle = INVALID_HANDLE;
-            return false;
+            return INVALID_HANDLE;
         }
 
-        void SecretKeyProperty::update_state(uint8_t *value, uint16_t value_len)
+        bool SecretKeyProperty::update_state(uint8_t *value, uint16_t value_len)
         {
-            if (value_len != SECRET_KEY_LENGTH)
-            {
-                ESP_LOGE(TAG, "[%s] Unexpected secret_key length: %d", this->component_->get_name().c_str(), value_len);
-                return;
-            }
+            if (!this->read_value(value, value_len))
+                return false;
 
             char key_str[SECRET_KEY_LENGTH * 2 + 1];
             encode_hex(value, value_len, key_str);
@@ -164,6 +224,7 @@ namespace esphome
             ESP_LOGI(TAG, "[%s] Consider adding below line to your danfoss_eco config:", this->component_->get_name().c_str());
             ESP_LOGI(TAG, "[%s] secret_key: %s", this->component_->get_name().c_str(), key_str);
             this->component_->set_secret_key(value, true);
+            return true;
         }
 
     } // namespace danfoss_eco
@@ -5,6 +5,7 @@
 
 #include "my_component.h"
 #include "device_data.h"
+#include "schema.h"
 
 namespace esphome
 {
@@ -14,19 +15,9 @@ namespace esphome
         using namespace esphome::esp32_ble_tracker;
         using namespace esphome::ble_client;
 
-        static auto SERVICE_SETTINGS = ESPBTUUID::from_raw("10020000-2749-0001-0000-00805f9b042f");
-        static auto CHARACTERISTIC_PIN = ESPBTUUID::from_raw("10020001-2749-0001-0000-00805f9b042f");         // 0x24
-        static auto CHARACTERISTIC_SETTINGS = ESPBTUUID::from_raw("10020003-2749-0001-0000-00805f9b042f");    // 0x2a
-        static auto CHARACTERISTIC_TEMPERATURE = ESPBTUUID::from_raw("10020005-2749-0001-0000-00805f9b042f"); // 0x2d
-        static auto CHARACTERISTIC_ERRORS = ESPBTUUID::from_raw("10020009-2749-0001-0000-00805f9b042f");      // 0x39
-        static auto CHARACTERISTIC_SECRET_KEY = ESPBTUUID::from_raw("1002000b-2749-0001-0000-00805f9b042f");  // 0x3f
-
-        static auto SERVICE_BATTERY = ESPBTUUID::from_uint32(0x180F);
-        static auto CHARACTERISTIC_BATTERY = ESPBTUUID::from_uint32(0x2A19); // 0x10
-
         const uint16_t INVALID_HANDLE = -1;
         
-        const uint8_t SECRET_KEY_LENGTH = 16;
+        const uint8_t SECRET_KEY_LENGTH = SecretKeySchema::LENGTH;
         struct SecretKeyValue
         {
             SecretKeyValue() {}
@@ -37,23 +28,78 @@ namespace esphome
             uint8_t value[SECRET_KEY_LENGTH];
         };
 
+        // characteristic handles are fixed per firmware, resolved handles are cached in flash to skip waiting for service discovery
+        const uint8_t CACHED_HANDLES_COUNT = 5;
+        struct HandleCacheValue
+        {
+            uint16_t handles[CACHED_HANDLES_COUNT];
+        };
+
+        // position of a property in Device::properties, commands refer to the properties by id
+        enum PropertyId : uint8_t
+        {
+            PROPERTY_PIN,
+            PROPERTY_BATTERY,
+            PROPERTY_TEMPERATURE,
+            PROPERTY_SETTINGS,
+            PROPERTY_ERRORS,
+            PROPERTY_SECRET_KEY,
+            PROPERTY_COUNT
+        };
+
+        // set of properties, bit per PropertyId
+        typedef uint8_t PropertyMask;
+        static_assert(PROPERTY_COUNT <= sizeof(PropertyMask) * 8, "PropertyMask is too narrow");
+
+        // the longest characteristic value, which is encrypted and written
+        const uint16_t MAX_VALUE_LENGTH = 16;
+
         class DeviceProperty
         {
         public:
-            unique_ptr<DeviceData> data{nullptr};
+            // uuids, length and encryption of the value are taken from the characteristic schema
+            template <class Schema>
+            DeviceProperty(shared_ptr<MyComponent> &component, const XxteaKey &xxtea, Schema) : value_length(Schema::LENGTH), encrypted(Schema::ENCRYPTED), component_(component), xxtea_(xxtea), service_uuid(Schema::service()), characteristic_uuid(Schema::characteristic()) {}
 
-            DeviceProperty(shared_ptr<MyComponent> &component, shared_ptr<Xxtea> &xxtea, ESPBTUUID s_uuid, ESPBTUUID c_uuid) : component_(component), xxtea_(xxtea), service_uuid(s_uuid), characteristic_uuid(c_uuid) {}
+            // returns false, if the value was rejected: it is then not considered fresh and is read again with the next poll
+            virtual bool update_state(uint8_t *value, uint16_t value_len) { return false; }
 
-            virtual void update_state(uint8_t *value, uint16_t value_len){};
-
-            virtual bool init_handle(BLEClient *);
+            // looks the characteristic up in the services discovered by the client, INVALID_HANDLE if it was not found.
+            // Runs in the BT task, the handle is only applied from the main loop
+            virtual uint16_t find_handle(BLEClient *);
             bool read_request(BLEClient *client);
 
-            uint16_t handle;
+            uint16_t handle = INVALID_HANDLE;
+            const uint16_t value_length; // characteristic values have fixed length, which allows batching them in read-multiple requests
+            const bool encrypted;
+
+            // the value is read once it is older than refresh_interval, 0 - on every poll.
+            // A value may get older than that by up to staleness_budget, otherwise it is read with the current poll
+            void set_refresh_interval(uint32_t refresh_interval)
+            {
+                this->refresh_interval = refresh_interval;
+                this->staleness_budget = refresh_interval / 10;
+            }
+            bool is_due(uint32_t now, uint32_t next_poll);
+            void mark_read(uint32_t now)
+            {
+                this->last_read_ = now;
+                this->read_once_ = true;
+            }
+
+            uint32_t refresh_interval = 0;
+            uint32_t staleness_budget = 0;
 
         protected:
+            bool check_length(uint16_t value_len);
+            // checks the length and decrypts the value in place, if the characteristic is encrypted
+            bool read_value(uint8_t *value, uint16_t value_len);
+
+            uint32_t last_read_ = 0;
+            bool read_once_ = false;
+
             shared_ptr<MyComponent> component_{nullptr};
-            shared_ptr<Xxtea> xxtea_{nullptr};
+            const XxteaKey &xxtea_; // owned by the device, read-only here
 
             ESPBTUUID service_uuid;
             ESPBTUUID characteristic_uuid;
@@ -62,48 +108,68 @@ namespace esphome
         class WritableProperty : public DeviceProperty
         {
         public:
-            WritableProperty(shared_ptr<MyComponent> &component, shared_ptr<Xxtea> &xxtea, ESPBTUUID s_uuid, ESPBTUUID c_uuid) : DeviceProperty(component, xxtea, s_uuid, c_uuid) {}
+            template <class Schema>
+            WritableProperty(shared_ptr<MyComponent> &component, const XxteaKey &xxtea, Schema schema) : DeviceProperty(component, xxtea, schema) {}
 
             bool write_request(BLEClient *client);
             bool write_request(BLEClient *client, uint8_t *data, uint16_t data_len);
+
+        protected:
+            // fills the plain value, which is then encrypted and written by write_request(BLEClient *)
+            virtual void pack(uint8_t *buff) {}
         };
 
         class BatteryProperty : public DeviceProperty
         {
         public:
-            BatteryProperty(shared_ptr<MyComponent> &component, shared_ptr<Xxtea> &xxtea) : DeviceProperty(component, xxtea, SERVICE_BATTERY, CHARACTERISTIC_BATTERY) {}
-            void update_state(uint8_t *value, uint16_t value_len) override;
+            BatteryProperty(shared_ptr<MyComponent> &component, const XxteaKey &xxtea) : DeviceProperty(component, xxtea, BatterySchema{}) {}
+            bool update_state(uint8_t *value, uint16_t value_len) override;
         };
 
         class TemperatureProperty : public WritableProperty
         {
         public:
-            TemperatureProperty(shared_ptr<MyComponent> &component, shared_ptr<Xxtea> &xxtea) : WritableProperty(component, xxtea, SERVICE_SETTINGS, CHARACTERISTIC_TEMPERATURE) {}
-            void update_state(uint8_t *value, uint16_t value_len) override;
+            TemperatureProperty(shared_ptr<MyComponent> &component, const XxteaKey &xxtea) : WritableProperty(component, xxtea, TemperatureData::Schema{}) {}
+            bool update_state(uint8_t *value, uint16_t value_len) override;
+
+            TemperatureData data;
+
+        protected:
+            void pack(uint8_t *buff) override { this->data.pack(buff); }
         };
 
         class SettingsProperty : public WritableProperty
         {
         public:
-            SettingsProperty(shared_ptr<MyComponent> &component, shared_ptr<Xxtea> &xxtea) : WritableProperty(component, xxtea, SERVICE_SETTINGS, CHARACTERISTIC_SETTINGS) {}
-            void update_state(uint8_t *value, uint16_t value_len) override;
+            SettingsProperty(shared_ptr<MyComponent> &component, const XxteaKey &xxtea) : WritableProperty(component, xxtea, SettingsData::Schema{}) {}
+            bool update_state(uint8_t *value, uint16_t value_len) override;
+
+            SettingsData data;
+
+        protected:
+            void pack(uint8_t *buff) override { this->data.pack(buff); }
         };
 
         class ErrorsProperty : public DeviceProperty
         {
         public:
-            ErrorsProperty(shared_ptr<MyComponent> &component, shared_ptr<Xxtea> &xxtea) : DeviceProperty(component, xxtea, SERVICE_SETTINGS, CHARACTERISTIC_ERRORS) {}
-            void update_state(uint8_t *value, uint16_t value_len) override;
+            ErrorsProperty(shared_ptr<MyComponent> &component, const XxteaKey &xxtea) : DeviceProperty(component, xxtea, ErrorsData::Schema{}) {}
+            bool update_state(uint8_t *value, uint16_t value_len) override;
+
+            ErrorsData data;
         };
 
         class SecretKeyProperty : public DeviceProperty
         {
         public:
-            SecretKeyProperty(shared_ptr<MyComponent> &component, shared_ptr<Xxtea> &xxtea) : DeviceProperty(component, xxtea, SERVICE_SETTINGS, CHARACTERISTIC_SECRET_KEY) {}
-            void update_state(uint8_t *value, uint16_t value_len) override;
+            SecretKeyProperty(shared_ptr<MyComponent> &component, const XxteaKey &xxtea) : DeviceProperty(component, xxtea, SecretKeySchema{}) {}
+            bool update_state(uint8_t *value, uint16_t value_len) override;
 
-            bool init_handle(BLEClient *) override;
+            uint16_t find_handle(BLEClient *) override;
         };
 
+        // reads values of several characteristics in a single ATT transaction, response is a concatenation of the values
+        bool read_multiple_request(BLEClient *client, const uint16_t *handles, uint8_t count);
+
     } // namespace danfoss_eco
 } // namespace esphome
\ No newline at end of file
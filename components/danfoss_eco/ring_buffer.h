@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace esphome
+{
+    namespace danfoss_eco
+    {
+        using namespace std;
+
+        // Fixed capacity lock-free single-producer/single-consumer queue.
+        // push() may only be called from one task and pop() from one (possibly other) task.
+        template <typename T, size_t N>
+        class RingBuffer
+        {
+            static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer capacity should be a power of two");
+
+        public:
+            // returns false, if the queue is full
+            bool push(const T &item)
+            {
+                size_t head = this->head_.load(memory_order_relaxed);
+                size_t used = head - this->tail_.load(memory_order_acquire);
+                if (used >= N)
+                    return false;
+
+                this->buffer_[head & (N - 1)] = item;
+                this->head_.store(head + 1, memory_order_release);
+
+                // only the producer writes it, the consumer may read it from another task
+                if (used + 1 > this->high_watermark_.load(memory_order_relaxed))
+                    this->high_watermark_.store(used + 1, memory_order_relaxed);
+                return true;
+            }
+
+            // returns false, if the queue is empty
+            bool pop(T &item)
+            {
+                size_t tail = this->tail_.load(memory_order_relaxed);
+                if (tail == this->head_.load(memory_order_acquire))
+                    return false;
+
+                item = this->buffer_[tail & (N - 1)];
+                this->tail_.store(tail + 1, memory_order_release);
+                return true;
+            }
+
+            // returns false, if the queue is empty; the item stays in the queue
+            bool peek(T &item) const
+            {
+                size_t tail = this->tail_.load(memory_order_relaxed);
+                if (tail == this->head_.load(memory_order_acquire))
+                    return false;
+
+                item = this->buffer_[tail & (N - 1)];
+                return true;
+            }
+
+            size_t size() const { return this->head_.load(memory_order_acquire) - this->tail_.load(memory_order_acquire); }
+            bool empty() const { return this->size() == 0; }
+            constexpr size_t capacity() const { return N; }
+
+            // the largest number of items, which were queued at the same time (updated by the producer)
+            size_t high_watermark() const { return this->high_watermark_.load(memory_order_relaxed); }
+
+        private:
+            T buffer_[N];
+            atomic<size_t> head_{0};
+            atomic<size_t> tail_{0};
+            atomic<size_t> high_watermark_{0};
+        };
+
+    } // namespace danfoss_eco
+} // namespace esphome
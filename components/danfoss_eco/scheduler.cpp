@@ -0,0 +1,415 @@
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#include "scheduler.h"
+#include "device.h"
+
+#ifdef USE_ESP32
+
+#include <esp_gap_ble_api.h>
+#include <esp_heap_caps.h>
+
+namespace esphome
+{
+    namespace danfoss_eco
+    {
+        static const uint32_t STATS_INTERVAL = 10 * 60 * 1000;
+        // requests, which have waited longer than this, are served in the request order regardless of the signal strength
+        static const uint32_t MAX_REQUEST_WAIT = 5 * 60 * 1000;
+
+        void ClientLease::gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param)
+        {
+            if (this->device != nullptr)
+                this->device->gattc_event_handler(event, gattc_if, param);
+        }
+
+        void ConnectionScheduler::setup()
+        {
+            if (this->leases_.empty() && any_of(this->devices_.begin(), this->devices_.end(), [](Device *d)
+                                                { return d->is_pooled(); }))
+            {
+                ESP_LOGE(TAG, "pooled devices require at least one client in the pool");
+                this->mark_failed();
+                return;
+            }
+
+            this->stats_.started_at = millis();
+            this->set_interval("stats", STATS_INTERVAL, [this]()
+                               { this->log_stats(); });
+
+#ifdef USE_DANFOSS_ECO_SCANNER
+            // the secret key can only be read for a short time after the hardware button was pressed
+            if (this->scanner_ != nullptr)
+                this->set_interval("secret_key", 1000, [this]()
+                                   {
+                                       this->provision_devices();
+                                       this->check_secret_keys();
+                                   });
+#endif
+        }
+
+        void ConnectionScheduler::dump_config()
+        {
+            ESP_LOGCONFIG(TAG, "Danfoss Eco Connection Scheduler:");
+            ESP_LOGCONFIG(TAG, "  Devices: %d", this->devices_.size());
+            if (!this->slots_.empty())
+            {
+                auto provisioned = count_if(this->slots_.begin(), this->slots_.end(), [](Device *d)
+                                            { return d->address() != 0; });
+                ESP_LOGCONFIG(TAG, "  Provisioned Slots: %d/%d", provisioned, this->slots_.size());
+            }
+            ESP_LOGCONFIG(TAG, "  Max Connections: %d", this->max_connections_);
+            if (!this->leases_.empty())
+                ESP_LOGCONFIG(TAG, "  Client Pool: %d clients", this->leases_.size());
+            ESP_LOGCONFIG(TAG, "  Connection Gap: %u ms", this->connection_gap_);
+            ESP_LOGCONFIG(TAG, "  Session Timeout: %u ms", this->session_timeout_);
+            ESP_LOGCONFIG(TAG, "  Stats Interval: %u ms", STATS_INTERVAL);
+            LOG_SENSOR("  ", "Heap Free", this->heap_free_);
+            LOG_SENSOR("  ", "Heap Low Watermark", this->heap_low_watermark_);
+            if (!this->devices_.empty())
+            {
+                // devices are of the same size
+                size_t device_usage = this->devices_.front()->memory_usage().total();
+                ESP_LOGCONFIG(TAG, "  Devices Memory (static estimate): %u bytes (%u per device)", device_usage * this->devices_.size(), device_usage);
+            }
+#ifdef USE_DANFOSS_ECO_SCANNER
+            if (this->scanner_ != nullptr)
+                ESP_LOGCONFIG(TAG, "  Presence Timeout: %u ms", this->presence_timeout_);
+#endif
+            this->log_heap();
+        }
+
+        void ConnectionScheduler::loop()
+        {
+            uint32_t now = millis();
+
+            // a session, which is stuck in connecting or waiting for a lost callback, should not block other devices
+            vector<Device *> expired;
+            for (auto &session : this->active_)
+                if (now - session.started_at > this->session_timeout_ &&
+                    !(session.device->is_established() && session.device->is_kept_alive()))
+                    expired.push_back(session.device);
+
+            for (auto device : expired)
+            {
+                ESP_LOGW(TAG, "[%s] session timed out after %u ms", device->get_name().c_str(), this->session_timeout_);
+                device->disconnect();
+            }
+
+            if (this->pending_.empty() || this->active_.size() >= this->max_connections_)
+                return;
+
+            if (now - this->last_session_start_ < this->connection_gap_)
+                return;
+
+            int i = this->next_request(now);
+            if (i < 0)
+                return;
+
+            Device *device = this->pending_[i].device;
+            this->pending_.erase(this->pending_.begin() + i);
+
+            // gap scanning interferes with connection attempts, which results in esp_gatt_status_t::ESP_GATT_ERROR (0x85)
+            if (this->active_.empty())
+                esp_ble_gap_stop_scanning();
+
+            if (device->is_pooled())
+                this->acquire_lease(device);
+
+            ESP_LOGD(TAG, "[%s] starting session, %d more pending", device->get_name().c_str(), this->pending_.size());
+            this->active_.push_back({device, now});
+            this->last_session_start_ = now;
+            device->connect();
+        }
+
+        uint32_t ConnectionScheduler::poll_offset(Device *device, uint32_t update_interval)
+        {
+            auto it = find(this->devices_.begin(), this->devices_.end(), device);
+            if (it == this->devices_.end())
+                return 0;
+
+            return (uint32_t)((uint64_t)update_interval * (it - this->devices_.begin()) / this->devices_.size());
+        }
+
+        bool ConnectionScheduler::request_session(Device *device, bool urgent)
+        {
+            if (this->is_active(device))
+                return false;
+
+            auto it = find_if(this->pending_.begin(), this->pending_.end(),
+                              [device](const Request &r)
+                              { return r.device == device; });
+            if (it != this->pending_.end())
+            {
+                // user initiated changes should not wait for the regular polls of other devices
+                if (urgent && !it->urgent)
+                {
+                    uint32_t requested_at = it->requested_at;
+                    this->pending_.erase(it);
+                    this->pending_.insert(this->pending_.begin(), {device, true, requested_at});
+                }
+                return false;
+            }
+
+            if (urgent)
+                this->pending_.insert(this->pending_.begin(), {device, true, millis()});
+            else
+                this->pending_.push_back({device, false, millis()});
+            return true;
+        }
+
+        int ConnectionScheduler::next_request(uint32_t now)
+        {
+            // polls of eTRVs, which are out of range, would only waste air time and hold the connection slot until the timeout
+            for (auto it = this->pending_.begin(); it != this->pending_.end();)
+            {
+                if (!it->urgent && !this->is_present(it->device, now))
+                {
+                    ESP_LOGD(TAG, "[%s] was not seen for %u ms, skipping poll", it->device->get_name().c_str(), this->presence_timeout_);
+                    this->stats_.skipped++;
+                    it = this->pending_.erase(it);
+                }
+                else
+                    it++;
+            }
+
+            // urgent requests are always at the front, followed by the regular ones in the request order
+            int best = -1;
+            for (int i = 0; i < (int)this->pending_.size(); i++)
+            {
+                Device *device = this->pending_[i].device;
+                if (!this->is_client_available(device))
+                    continue;
+
+                if (this->pending_[i].urgent)
+                    return i;
+
+                // with more polls than the sessions can serve, an eTRV with a weak signal would never get its turn
+                if (now - this->pending_[i].requested_at >= MAX_REQUEST_WAIT)
+                {
+                    ESP_LOGD(TAG, "[%s] waited for %u ms, serving it first", device->get_name().c_str(), now - this->pending_[i].requested_at);
+                    return i;
+                }
+
+                // connection to the eTRV with the strongest signal is the most likely to succeed
+                if (best < 0 || this->rssi(device) > this->rssi(this->pending_[best].device))
+                    best = i;
+            }
+            return best;
+        }
+
+        void ConnectionScheduler::add_client(esphome::ble_client::BLEClient *client)
+        {
+            auto lease = unique_ptr<ClientLease>(new ClientLease());
+            client->register_ble_node(lease.get());
+            this->leases_.push_back(move(lease));
+        }
+
+        bool ConnectionScheduler::is_client_available(Device *device)
+        {
+            if (device->is_pooled())
+                return this->free_lease() != nullptr;
+
+            return this->is_client_idle(device->parent());
+        }
+
+        bool ConnectionScheduler::is_client_idle(esphome::ble_client::BLEClient *client)
+        {
+            // a shared ble_client serves a single session at a time, and should finish closing the previous one first
+            for (auto &session : this->active_)
+                if (session.device->parent() == client)
+                    return false;
+
+            return client->state() == ClientState::IDLE;
+        }
+
+        ClientLease *ConnectionScheduler::free_lease()
+        {
+            for (auto &lease : this->leases_)
+                if (lease->device == nullptr && this->is_client_idle(lease->parent()))
+                    return lease.get();
+            return nullptr;
+        }
+
+        void ConnectionScheduler::acquire_lease(Device *device)
+        {
+            // availability was checked by next_request()
+            ClientLease *lease = this->free_lease();
+            lease->device = device;
+            device->set_ble_client_parent(lease->parent());
+        }
+
+        void ConnectionScheduler::release_lease(Device *device)
+        {
+            for (auto &lease : this->leases_)
+                if (lease->device == device)
+                    lease->device = nullptr;
+        }
+
+        bool ConnectionScheduler::is_present(Device *device, uint32_t now)
+        {
+#ifdef USE_DANFOSS_ECO_SCANNER
+            if (this->scanner_ == nullptr)
+                return true;
+
+            auto adv = this->scanner_->get_advertisement(device->address());
+            if (adv == nullptr)
+                return now < this->presence_timeout_; // the scanner did not have a chance to see it since boot
+
+            return now - adv->last_seen <= this->presence_timeout_;
+#else
+            return true;
+#endif
+        }
+
+        int8_t ConnectionScheduler::rssi(Device *device)
+        {
+#ifdef USE_DANFOSS_ECO_SCANNER
+            if (this->scanner_ != nullptr)
+            {
+                auto adv = this->scanner_->get_advertisement(device->address());
+                if (adv != nullptr)
+                    return adv->rssi;
+            }
+#endif
+            return INT8_MIN;
+        }
+
+        bool ConnectionScheduler::secret_key_readable(Device *device)
+        {
+#ifdef USE_DANFOSS_ECO_SCANNER
+            if (this->scanner_ == nullptr)
+                return true;
+
+            auto adv = this->scanner_->get_advertisement(device->address());
+            return adv != nullptr && (adv->flags & danfoss_eco_scanner::FLAG_SECRET_KEY_READABLE) && millis() - adv->last_seen <= this->presence_timeout_;
+#else
+            return true;
+#endif
+        }
+
+        void ConnectionScheduler::check_secret_keys()
+        {
+            for (auto device : this->devices_)
+                if (device->xxtea.status() == XXTEA_STATUS_NOT_INITIALIZED && this->secret_key_readable(device) && this->request_session(device, true))
+                    ESP_LOGI(TAG, "[%s] hardware button was pressed, connecting to read the secret key", device->get_name().c_str());
+        }
+
+        void ConnectionScheduler::provision_devices()
+        {
+#ifdef USE_DANFOSS_ECO_SCANNER
+            if (this->slots_.empty())
+                return;
+
+            uint32_t now = millis();
+            this->scanner_->for_each_advertisement([this, now](uint64_t address, const danfoss_eco_scanner::Advertisement &adv)
+                                                   {
+                                                       // only eTRVs with the hardware button pressed are adopted, neighbours' radiators stay untouched
+                                                       if (!(adv.flags & danfoss_eco_scanner::FLAG_SECRET_KEY_READABLE) || now - adv.last_seen > this->presence_timeout_)
+                                                           return;
+
+                                                       if (this->find_device(address) == nullptr)
+                                                           this->provision(address);
+                                                   });
+#endif
+        }
+
+        Device *ConnectionScheduler::find_device(uint64_t address)
+        {
+            auto it = find_if(this->devices_.begin(), this->devices_.end(), [address](Device *d)
+                              { return d->address() == address; });
+            return it != this->devices_.end() ? *it : nullptr;
+        }
+
+        void ConnectionScheduler::provision(uint64_t address)
+        {
+            auto slot = find_if(this->slots_.begin(), this->slots_.end(), [](Device *d)
+                                { return d->address() == 0; });
+            if (slot == this->slots_.end())
+            {
+                if (!this->slots_full_logged_)
+                    ESP_LOGW(TAG, "all %d slots are provisioned, ignoring eTRV MAC: %s", this->slots_.size(), format_address(address).c_str());
+                this->slots_full_logged_ = true;
+                return;
+            }
+
+            (*slot)->bind(address);
+        }
+
+        void ConnectionScheduler::release_session(Device *device, bool success)
+        {
+            auto it = find_if(this->active_.begin(), this->active_.end(),
+                              [device](const Session &s)
+                              { return s.device == device; });
+
+            if (it == this->active_.end())
+                return;
+
+            uint32_t duration = millis() - it->started_at;
+            this->active_.erase(it);
+            this->release_lease(device);
+
+            this->stats_.sessions++;
+            if (success)
+            {
+                ESP_LOGD(TAG, "[%s] session finished in %u ms", device->get_name().c_str(), duration);
+                this->stats_.duration_total += duration;
+                this->stats_.duration_max = max(this->stats_.duration_max, duration);
+            }
+            else
+            {
+                ESP_LOGD(TAG, "[%s] session failed after %u ms", device->get_name().c_str(), duration);
+                this->stats_.failures++;
+            }
+        }
+
+        void ConnectionScheduler::log_stats()
+        {
+            auto &stats = this->stats_;
+            uint32_t elapsed = millis() - stats.started_at;
+            uint16_t succeeded = stats.sessions - stats.failures;
+
+            if (stats.sessions > 0 && elapsed > 0)
+                ESP_LOGI(TAG, "sessions: %.1f/min, failed: %.0f%%, session duration: avg=%u ms, max=%u ms, pending: %d, skipped polls: %d",
+                         stats.sessions * 60000.0f / elapsed,
+                         stats.failures * 100.0f / stats.sessions,
+                         succeeded > 0 ? stats.duration_total / succeeded : 0,
+                         stats.duration_max,
+                         this->pending_.size(),
+                         stats.skipped);
+
+            this->log_heap();
+
+            stats = SessionStats();
+            stats.started_at = millis();
+        }
+
+        void ConnectionScheduler::log_heap()
+        {
+            // fragmentation is the share of free memory, which can not be allocated as a single block
+            size_t free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+            size_t low_watermark = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+            size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+            ESP_LOGI(TAG, "heap: free=%u, low watermark=%u, largest block=%u, fragmentation=%.0f%%",
+                     free,
+                     low_watermark,
+                     largest,
+                     free > 0 ? 100.0f - largest * 100.0f / free : 0.0f);
+
+            if (this->heap_free_ != nullptr)
+                this->heap_free_->publish_state(free);
+            if (this->heap_low_watermark_ != nullptr)
+                this->heap_low_watermark_->publish_state(low_watermark);
+        }
+
+        bool ConnectionScheduler::is_active(Device *device)
+        {
+            return find_if(this->active_.begin(), this->active_.end(),
+                           [device](const Session &s)
+                           { return s.device == device; }) != this->active_.end();
+        }
+
+    } // namespace danfoss_eco
+} // namespace esphome
+
+#endif // USE_ESP32
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/components/ble_client/ble_client.h"
+#include "esphome/components/sensor/sensor.h"
+
+#include "helpers.h"
+
+#ifdef USE_ESP32
+
+#ifdef USE_DANFOSS_ECO_SCANNER
+#include "esphome/components/danfoss_eco_scanner/device_scanner.h"
+#endif
+
+namespace esphome
+{
+    namespace danfoss_eco
+    {
+        using namespace std;
+
+        class Device;
+
+        // A ble_client of the pool. Its events are forwarded to the device, which holds the lease for the current session,
+        // so the client has a single node no matter how many devices share it.
+        class ClientLease : public esphome::ble_client::BLEClientNode
+        {
+        public:
+            void gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param) override;
+
+            Device *device{nullptr};
+        };
+
+        // Owns the connection slots of all Danfoss Eco devices on this node.
+        // Devices request a session, the scheduler connects them one by one (or up to max_connections in parallel),
+        // keeping a gap between connection attempts and enforcing the hard limit on the session duration.
+        class ConnectionScheduler : public Component
+        {
+        public:
+            float get_setup_priority() const override { return setup_priority::DATA; }
+
+            void setup() override;
+            void dump_config() override;
+            void loop() override;
+
+            void set_max_connections(uint8_t max_connections) { this->max_connections_ = max_connections; }
+            void set_connection_gap(uint32_t connection_gap) { this->connection_gap_ = connection_gap; }
+            void set_session_timeout(uint32_t session_timeout) { this->session_timeout_ = session_timeout; }
+            void set_presence_timeout(uint32_t presence_timeout) { this->presence_timeout_ = presence_timeout; }
+#ifdef USE_DANFOSS_ECO_SCANNER
+            void set_scanner(danfoss_eco_scanner::DanfossEcoScanner *scanner) { this->scanner_ = scanner; }
+#endif
+
+            void set_heap_free(sensor::Sensor *heap_free) { this->heap_free_ = heap_free; }
+            void set_heap_low_watermark(sensor::Sensor *heap_low_watermark) { this->heap_low_watermark_ = heap_low_watermark; }
+
+            void register_device(Device *device) { this->devices_.push_back(device); }
+            // slots are bound to eTRVs found by the scanner, they usually share a single ble_client
+            void register_slot(Device *device) { this->slots_.push_back(device); }
+            void add_client(esphome::ble_client::BLEClient *client);
+
+            // delay of the first poll, which spreads devices evenly across the update_interval
+            uint32_t poll_offset(Device *device, uint32_t update_interval);
+
+            // returns false, if the device already has a pending or active session
+            bool request_session(Device *device, bool urgent);
+            void release_session(Device *device, bool success);
+
+            // the eTRV has advertised, that the secret key can be read. Always true without a scanner
+            bool secret_key_readable(Device *device);
+
+        protected:
+            struct Session
+            {
+                Device *device;
+                uint32_t started_at;
+            };
+
+            struct Request
+            {
+                Device *device;
+                bool urgent;           // changes from HA are sent, even if the eTRV was not seen recently
+                uint32_t requested_at; // millis
+            };
+
+            bool is_active(Device *device);
+            bool is_client_available(Device *device);
+            bool is_client_idle(esphome::ble_client::BLEClient *client);
+            ClientLease *free_lease();
+            void acquire_lease(Device *device);
+            void release_lease(Device *device);
+            int next_request(uint32_t now);
+            bool is_present(Device *device, uint32_t now);
+            int8_t rssi(Device *device);
+            void check_secret_keys();
+            void provision_devices();
+            void provision(uint64_t address);
+            Device *find_device(uint64_t address);
+            void log_stats();
+            void log_heap();
+
+            vector<Device *> devices_;
+            vector<Device *> slots_;
+            vector<unique_ptr<ClientLease>> leases_;
+            bool slots_full_logged_{false};
+            vector<Request> pending_;
+            vector<Session> active_;
+
+            uint8_t max_connections_{1};
+            uint32_t connection_gap_{2000};
+            uint32_t session_timeout_{60000};
+            uint32_t presence_timeout_{300000};
+            uint32_t last_session_start_{0};
+
+            // session statistics, accumulated since the previous stats report
+            struct SessionStats
+            {
+                uint32_t started_at{0};
+                uint16_t sessions{0};
+                uint16_t failures{0};
+                uint16_t skipped{0}; // polls of eTRVs, which were not seen by the scanner
+                uint32_t duration_total{0}; // successful sessions, from the session start to the disconnect
+                uint32_t duration_max{0};
+            } stats_;
+
+            sensor::Sensor *heap_free_{nullptr};
+            sensor::Sensor *heap_low_watermark_{nullptr};
+
+#ifdef USE_DANFOSS_ECO_SCANNER
+            danfoss_eco_scanner::DanfossEcoScanner *scanner_{nullptr};
+#endif
+        };
+
+    } // namespace danfoss_eco
+} // namespace esphome
+
+#endif // USE_ESP32
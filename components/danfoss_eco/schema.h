@@ -0,0 +1,186 @@
+#pragma once
+
+#include "esphome/components/esp32_ble_tracker/esp32_ble_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace esphome
+{
+    namespace danfoss_eco
+    {
+        using namespace std;
+        using namespace esphome::esp32_ble_tracker;
+
+        // Layout of the Danfoss Eco characteristics. Every field is a type, which knows its offset and encoding,
+        // decode() and encode() are resolved at compile time and a field outside of its characteristic does not compile.
+        // Values are big-endian, encryption is applied to the whole value by the property.
+        // mark() sets the bits, which are written by encode(), in a mask of the same length as the value.
+        namespace field
+        {
+            template <uint16_t Length, uint8_t Offset>
+            struct Byte
+            {
+                static_assert(Offset < Length, "field is outside of the characteristic");
+
+                static uint8_t decode(const uint8_t *value) { return value[Offset]; }
+                static void encode(uint8_t *value, uint8_t x) { value[Offset] = x; }
+                static void mark(uint8_t *mask) { mask[Offset] = 0xFF; }
+            };
+
+            // 0.5°C units
+            template <uint16_t Length, uint8_t Offset>
+            struct Temperature
+            {
+                static_assert(Offset < Length, "field is outside of the characteristic");
+
+                static float decode(const uint8_t *value) { return value[Offset] / 2.0f; }
+                static void encode(uint8_t *value, float temperature)
+                {
+                    // a value out of the byte range must not wrap around
+                    value[Offset] = isnan(temperature) ? 0 : (uint8_t)(min(max(temperature, 0.0f), 127.5f) * 2);
+                }
+                static void mark(uint8_t *mask) { mask[Offset] = 0xFF; }
+            };
+
+            template <uint16_t Length, uint8_t Offset>
+            struct UInt16
+            {
+                static_assert(Offset + sizeof(uint16_t) <= Length, "field is outside of the characteristic");
+
+                static uint16_t decode(const uint8_t *value) { return value[Offset] << 8 | value[Offset + 1]; }
+            };
+
+            template <uint16_t Length, uint8_t Offset>
+            struct UInt32
+            {
+                static_assert(Offset + sizeof(uint32_t) <= Length, "field is outside of the characteristic");
+
+                static uint32_t decode(const uint8_t *value)
+                {
+                    return (uint32_t)value[Offset] << 24 | value[Offset + 1] << 16 | value[Offset + 2] << 8 | value[Offset + 3];
+                }
+                static void encode(uint8_t *value, uint32_t x)
+                {
+                    value[Offset] = x >> 24;
+                    value[Offset + 1] = x >> 16;
+                    value[Offset + 2] = x >> 8;
+                    value[Offset + 3] = x;
+                }
+                static void mark(uint8_t *mask) { memset(mask + Offset, 0xFF, sizeof(uint32_t)); }
+            };
+
+            // a single bit of a byte
+            template <uint16_t Length, uint8_t Offset, uint8_t Bit>
+            struct Flag
+            {
+                static_assert(Offset < Length, "field is outside of the characteristic");
+                static_assert(Bit < 8, "bit is outside of the byte");
+
+                static bool decode(const uint8_t *value) { return (value[Offset] >> Bit) & 1; }
+                static void encode(uint8_t *value, bool x)
+                {
+                    if (x)
+                        value[Offset] |= 1 << Bit;
+                    else
+                        value[Offset] &= ~(1 << Bit);
+                }
+                static void mark(uint8_t *mask) { mask[Offset] |= 1 << Bit; }
+            };
+
+            // a single bit of a big-endian 16 bit word
+            template <uint16_t Length, uint8_t Offset, uint8_t Bit>
+            struct Flag16
+            {
+                static_assert(Bit < 16, "bit is outside of the word");
+
+                static bool decode(const uint8_t *value) { return (UInt16<Length, Offset>::decode(value) >> Bit) & 1; }
+            };
+        } // namespace field
+
+        template <uint16_t Length, bool Encrypted>
+        struct Characteristic
+        {
+            static const uint16_t LENGTH = Length;
+            static const bool ENCRYPTED = Encrypted;
+
+            template <uint8_t Offset>
+            using Byte = field::Byte<Length, Offset>;
+            template <uint8_t Offset>
+            using Temperature = field::Temperature<Length, Offset>;
+            template <uint8_t Offset>
+            using UInt32 = field::UInt32<Length, Offset>;
+            template <uint8_t Offset, uint8_t Bit>
+            using Flag = field::Flag<Length, Offset, Bit>;
+            template <uint8_t Offset, uint8_t Bit>
+            using Flag16 = field::Flag16<Length, Offset, Bit>;
+        };
+
+        static auto SERVICE_SETTINGS = ESPBTUUID::from_raw("10020000-2749-0001-0000-00805f9b042f");
+        static auto SERVICE_BATTERY = ESPBTUUID::from_uint32(0x180F);
+
+        struct PinSchema : Characteristic<4, false>
+        {
+            static ESPBTUUID service() { return SERVICE_SETTINGS; }
+            static ESPBTUUID characteristic() { return ESPBTUUID::from_raw("10020001-2749-0001-0000-00805f9b042f"); } // 0x24
+
+            using pin_code = UInt32<0>;
+        };
+
+        struct BatterySchema : Characteristic<1, false>
+        {
+            static ESPBTUUID service() { return SERVICE_BATTERY; }
+            static ESPBTUUID characteristic() { return ESPBTUUID::from_uint32(0x2A19); } // 0x10
+
+            using battery_level = Byte<0>;
+        };
+
+        struct TemperatureSchema : Characteristic<8, true>
+        {
+            static ESPBTUUID service() { return SERVICE_SETTINGS; }
+            static ESPBTUUID characteristic() { return ESPBTUUID::from_raw("10020005-2749-0001-0000-00805f9b042f"); } // 0x2d
+
+            using target_temperature = Temperature<0>;
+            using room_temperature = Temperature<1>;
+        };
+
+        struct SettingsSchema : Characteristic<16, true>
+        {
+            static ESPBTUUID service() { return SERVICE_SETTINGS; }
+            static ESPBTUUID characteristic() { return ESPBTUUID::from_raw("10020003-2749-0001-0000-00805f9b042f"); } // 0x2a
+
+            using adaptable_regulation = Flag<0, 0>;
+            using vertical_installation = Flag<0, 2>;
+            using display_flip = Flag<0, 3>;
+            using slow_regulation = Flag<0, 4>;
+            using valve_installed = Flag<0, 6>;
+            using lock_control = Flag<0, 7>;
+            using temperature_min = Temperature<1>;
+            using temperature_max = Temperature<2>;
+            using frost_protection_temperature = Temperature<3>;
+            using device_mode = Byte<4>;
+            using vacation_temperature = Temperature<5>;
+            using vacation_from = UInt32<6>; // utc
+            using vacation_to = UInt32<10>;  // utc
+        };
+
+        struct ErrorsSchema : Characteristic<8, true>
+        {
+            static ESPBTUUID service() { return SERVICE_SETTINGS; }
+            static ESPBTUUID characteristic() { return ESPBTUUID::from_raw("10020009-2749-0001-0000-00805f9b042f"); } // 0x39
+
+            using valve_does_not_close = Flag16<0, 8>; // E9
+            using invalid_time = Flag16<0, 9>;         // E10
+            using low_battery = Flag16<0, 13>;         // E14
+            using very_low_battery = Flag16<0, 14>;    // E15
+        };
+
+        struct SecretKeySchema : Characteristic<16, false>
+        {
+            static ESPBTUUID service() { return SERVICE_SETTINGS; }
+            static ESPBTUUID characteristic() { return ESPBTUUID::from_raw("1002000b-2749-0001-0000-00805f9b042f"); } // 0x3f
+        };
+
+    } // namespace danfoss_eco
+} // namespace esphome
@@ -0,0 +1,17 @@
+#include "device.h"
+#include "settings.h"
+
+#ifdef USE_ESP32
+
+namespace esphome
+{
+    namespace danfoss_eco
+    {
+        void SettingSwitch::write_state(bool state) { this->device_->write_setting(this->id_, state); }
+
+        void SettingNumber::control(float value) { this->device_->write_setting(this->id_, value); }
+
+    } // namespace danfoss_eco
+} // namespace esphome
+
+#endif // USE_ESP32
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "esphome/components/switch/switch.h"
+#include "esphome/components/number/number.h"
+#include "esphome/core/hal.h"
+
+#include "helpers.h"
+
+namespace esphome
+{
+    namespace danfoss_eco
+    {
+        using namespace std;
+
+        class Device;
+
+        // device settings, which are exposed as entities, all of them are stored in the settings characteristic
+        enum SettingId : uint8_t
+        {
+            SETTING_ADAPTABLE_REGULATION,
+            SETTING_DISPLAY_FLIP,
+            SETTING_LOCK_CONTROL,
+            SETTING_TEMPERATURE_MIN,
+            SETTING_TEMPERATURE_MAX,
+            SETTING_FROST_PROTECTION_TEMPERATURE,
+            SETTING_VACATION_TEMPERATURE,
+            SETTING_COUNT
+        };
+
+        // entity of a single setting, changes are handed over to the device, which batches them into a single write
+        class SettingEntity
+        {
+        public:
+            SettingEntity(SettingId id) : id_(id) {}
+
+            void set_device(Device *device) { this->device_ = device; }
+            SettingId setting() const { return this->id_; }
+
+            // publishes the value, unless it has not changed and was published less than max_silence ago, 0 - publish it now
+            void publish_setting(float value, uint32_t max_silence)
+            {
+                uint32_t now = millis();
+                if (!this->published_ || !this->has_value(value) || heartbeat_due(now, this->last_publish_, max_silence))
+                {
+                    this->publish_value(value);
+                    this->published_ = true;
+                    this->last_publish_ = now;
+                }
+            }
+
+        protected:
+            // the published state of the entity equals to the value
+            virtual bool has_value(float value) = 0;
+            virtual void publish_value(float value) = 0;
+
+            const SettingId id_;
+            Device *device_{nullptr};
+            bool published_ = false;
+            uint32_t last_publish_ = 0;
+        };
+
+        class SettingSwitch : public switch_::Switch, public SettingEntity
+        {
+        public:
+            SettingSwitch(SettingId id) : SettingEntity(id) {}
+
+        protected:
+            bool has_value(float value) override { return this->state == (value != 0); }
+            void publish_value(float value) override { this->publish_state(value != 0); }
+            void write_state(bool state) override;
+        };
+
+        class SettingNumber : public number::Number, public SettingEntity
+        {
+        public:
+            SettingNumber(SettingId id) : SettingEntity(id) {}
+
+        protected:
+            bool has_value(float value) override { return this->has_state() && same_value(this->state, value); }
+            void publish_value(float value) override { this->publish_state(value); }
+            void control(float value) override;
+        };
+
+    } // namespace danfoss_eco
+} // namespace esphome
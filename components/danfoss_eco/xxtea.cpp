@@ -1,110 +1,66 @@
 #include "xxtea.h"
-#include <xxtea_core.h>
 
-int Xxtea::set_key(uint8_t *key, size_t len)
+int XxteaKey::set(const uint8_t *key, size_t len)
 {
-    this->status_ = XXTEA_STATUS_GENERAL_ERROR;
-    size_t osz;
-
-    do
+    // Parameter Check
+    if (key == NULL || len <= 0 || len > MAX_XXTEA_KEY8)
     {
-        // Parameter Check
-        if (key == NULL || len <= 0 || len > MAX_XXTEA_KEY8)
-        {
-            this->status_ = XXTEA_STATUS_PARAMETER_ERROR;
-            break;
-        }
-
-        osz = UINT32CALCBYTE(len);
-
-        // Check for Size Errors
-        if (osz > MAX_XXTEA_KEY32)
-        {
-            this->status_ = XXTEA_STATUS_SIZE_ERROR;
-            break;
-        }
+        this->status_.store(XXTEA_STATUS_PARAMETER_ERROR, std::memory_order_release);
+        return XXTEA_STATUS_PARAMETER_ERROR;
+    }
 
-        // Clear the Key
-        memset((void *)this->xxtea_key, 0, MAX_XXTEA_KEY8);
+    // Key words are little-endian, decode them once instead of on every round
+    uint32_t words[MAX_XXTEA_KEY32]{0};
+    for (size_t i = 0; i < len; i++)
+        words[i / 4] |= (uint32_t)key[i] << (8 * (i % 4));
 
-        // Copy the Key from Buffer
-        memcpy((void *)this->xxtea_key, (const void *)key, len);
+    memcpy((void *)this->words_, (const void *)words, sizeof(words));
 
-        // We have Success
-        this->status_ = XXTEA_STATUS_SUCCESS;
-    } while (0);
-
-    return this->status_;
+    // publish the key words to the other tasks
+    this->status_.store(XXTEA_STATUS_SUCCESS, std::memory_order_release);
+    return XXTEA_STATUS_SUCCESS;
 }
 
-int Xxtea::encrypt(uint8_t *data, size_t len, uint8_t *buf, size_t *maxlen)
+int xxtea_encrypt(const XxteaKey &key, uint8_t *data, size_t len)
 {
-    int ret = XXTEA_STATUS_GENERAL_ERROR;
-    int32_t l;
-    do
-    {
-        if (data == NULL || len <= 0 || len > MAX_XXTEA_DATA8 ||
-            buf == NULL || *maxlen <= 0 || *maxlen < len)
-        {
-            ret = XXTEA_STATUS_PARAMETER_ERROR;
-            break;
-        }
-        // Calculate the Length needed for the 32bit Buffer
-        l = UINT32CALCBYTE(len);
+    if (key.status() != XXTEA_STATUS_SUCCESS)
+        return XXTEA_STATUS_GENERAL_ERROR;
+    if (data == NULL)
+        return XXTEA_STATUS_PARAMETER_ERROR;
 
-        // Check if More than expected space is needed
-        if (l > MAX_XXTEA_DATA32 || *maxlen < (l * 4))
-        {
-            ret = XXTEA_STATUS_SIZE_ERROR;
-            break;
-        }
+    switch (len)
+    {
+    case XxteaBlock<2>::LENGTH:
+        XxteaBlock<2>::encrypt(data, key.words());
+        return XXTEA_STATUS_SUCCESS;
 
-        // Clear the Data
-        memset((void *)this->xxtea_data, 0, MAX_XXTEA_DATA8);
+    case XxteaBlock<4>::LENGTH:
+        XxteaBlock<4>::encrypt(data, key.words());
+        return XXTEA_STATUS_SUCCESS;
 
-        // Copy the Data from Buffer
-        memcpy((void *)this->xxtea_data, (const void *)data, len);
+    default:
+        return XXTEA_STATUS_SIZE_ERROR;
+    }
+}
 
-        // Perform Encryption - Change for Unsigned Handling while using memory Pointer (18th July 2017)
-        dtea_fn1(this->xxtea_data, l, (const uint32_t *)this->xxtea_key);
+int xxtea_decrypt(const XxteaKey &key, uint8_t *data, size_t len)
+{
+    if (key.status() != XXTEA_STATUS_SUCCESS)
+        return XXTEA_STATUS_GENERAL_ERROR;
+    if (data == NULL)
+        return XXTEA_STATUS_PARAMETER_ERROR;
 
-        // Copy Encrypted Data back to buffer
-        memcpy((void *)buf, (const void *)this->xxtea_data, (l * 4));
+    switch (len)
+    {
+    case XxteaBlock<2>::LENGTH:
+        XxteaBlock<2>::decrypt(data, key.words());
+        return XXTEA_STATUS_SUCCESS;
 
-        // Assign the Length
-        *maxlen = l * 4;
+    case XxteaBlock<4>::LENGTH:
+        XxteaBlock<4>::decrypt(data, key.words());
+        return XXTEA_STATUS_SUCCESS;
 
-        ret = XXTEA_STATUS_SUCCESS;
-    } while (0);
-    return ret;
+    default:
+        return XXTEA_STATUS_SIZE_ERROR;
+    }
 }
-
-int Xxtea::decrypt(uint8_t *data, size_t len)
-{
-    int ret = XXTEA_STATUS_GENERAL_ERROR;
-    int32_t l;
-    do
-    {
-        if (data == NULL || len <= 0 || (len % 4) != 0)
-        {
-            ret = XXTEA_STATUS_PARAMETER_ERROR;
-            break;
-        }
-        if (len > MAX_XXTEA_DATA8)
-        {
-            ret = XXTEA_STATUS_SIZE_ERROR;
-            break;
-        }
-        // Copy the Data into Processing Array
-        memset((void *)this->xxtea_data, 0, MAX_XXTEA_DATA8);
-        memcpy((void *)this->xxtea_data, (const void *)data, len);
-        // Get the Actual Size in 32bits - Negative for Decryption
-        l = -((int32_t)len / 4); // - Change for Using correct Signed arithmetic (18th July 2017)
-        // Performn Decryption - Change for Unsigned Handling while using memory Pointer (18th July 2017)
-        dtea_fn1(this->xxtea_data, l, (const uint32_t *)this->xxtea_key);
-        // Copy Encrypted Data back to buffer
-        memcpy((void *)data, (const void *)this->xxtea_data, len);
-        ret = XXTEA_STATUS_SUCCESS;
-    } while (0);
-    return ret;
-}
\ No newline at end of file
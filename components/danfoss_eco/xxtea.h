@@ -2,29 +2,114 @@
 
 #include <xxtea-lib.h>
 
+#include <atomic>
+
 // key Size is always fixed
 #define MAX_XXTEA_KEY8 16
 // 32 Bit
 #define MAX_XXTEA_KEY32 4
-// DWORD Size of Data Buffer
-#define MAX_XXTEA_DATA32 (UINT32CALCBYTE(MAX_XXTEA_DATA8))
 
 #define XXTEA_STATUS_NOT_INITIALIZED -1
 
-class Xxtea
+#define XXTEA_DELTA 0x9e3779b9
+
+// XXTEA (corrected block TEA) for the fixed value lengths of the Danfoss Eco protocol.
+// The device treats the data as big-endian 32 bit words, the byte order is converted while the words are loaded and stored,
+// so the value is encrypted in place without copying it to intermediate buffers.
+// N is the number of 32 bit words, known at compile time, which allows the compiler to unroll the rounds.
+template <size_t N>
+class XxteaBlock
 {
+    static_assert(N >= 2, "XXTEA block should be at least 2 words long");
+    static const uint32_t ROUNDS = 6 + 52 / N;
+
 public:
-    Xxtea() : status_(XXTEA_STATUS_NOT_INITIALIZED){};
+    static const size_t LENGTH = N * 4;
+
+    static void encrypt(uint8_t *data, const uint32_t *key)
+    {
+        uint32_t v[N];
+        load(data, v);
 
-    int set_key(uint8_t *key, size_t len);
+        uint32_t sum = 0, y, z = v[N - 1];
+        for (uint32_t round = 0; round < ROUNDS; round++)
+        {
+            sum += XXTEA_DELTA;
+            uint32_t e = (sum >> 2) & 3;
+            for (size_t p = 0; p < N - 1; p++)
+            {
+                y = v[p + 1];
+                z = v[p] += mx(sum, y, z, p, e, key);
+            }
+            y = v[0];
+            z = v[N - 1] += mx(sum, y, z, N - 1, e, key);
+        }
 
-    int encrypt(uint8_t *data, size_t len, uint8_t *buf, size_t *maxlen);
-    int decrypt(uint8_t *data, size_t len);
+        store(v, data);
+    }
 
-    int status() { return this->status_; }
+    static void decrypt(uint8_t *data, const uint32_t *key)
+    {
+        uint32_t v[N];
+        load(data, v);
+
+        uint32_t sum = ROUNDS * XXTEA_DELTA, y = v[0], z;
+        for (uint32_t round = 0; round < ROUNDS; round++)
+        {
+            uint32_t e = (sum >> 2) & 3;
+            for (size_t p = N - 1; p > 0; p--)
+            {
+                z = v[p - 1];
+                y = v[p] -= mx(sum, y, z, p, e, key);
+            }
+            z = v[N - 1];
+            y = v[0] -= mx(sum, y, z, 0, e, key);
+            sum -= XXTEA_DELTA;
+        }
+
+        store(v, data);
+    }
 
 private:
-    int status_;
-    uint32_t xxtea_data[MAX_XXTEA_DATA32];
-    uint32_t xxtea_key[MAX_XXTEA_KEY32];
-};
\ No newline at end of file
+    static inline uint32_t mx(uint32_t sum, uint32_t y, uint32_t z, size_t p, uint32_t e, const uint32_t *key)
+    {
+        return (((z >> 5) ^ (y << 2)) + ((y >> 3) ^ (z << 4))) ^ ((sum ^ y) + (key[(p & 3) ^ e] ^ z));
+    }
+
+    static inline void load(const uint8_t *data, uint32_t *v)
+    {
+        for (size_t i = 0; i < N; i++, data += 4)
+            v[i] = (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+    }
+
+    static inline void store(const uint32_t *v, uint8_t *data)
+    {
+        for (size_t i = 0; i < N; i++, data += 4)
+        {
+            data[0] = v[i] >> 24;
+            data[1] = v[i] >> 16;
+            data[2] = v[i] >> 8;
+            data[3] = v[i];
+        }
+    }
+};
+
+// Key material of a device. The key is set once (from config, flash, or read from the device) and is only read afterwards,
+// encryption does not keep any state in the key, so values can be encrypted and decrypted from any task at the same time.
+class XxteaKey
+{
+public:
+    int set(const uint8_t *key, size_t len);
+
+    // XXTEA_STATUS_SUCCESS once the key was set, words() should not be used before that
+    int status() const { return this->status_.load(std::memory_order_acquire); }
+    const uint32_t *words() const { return this->words_; }
+
+private:
+    uint32_t words_[MAX_XXTEA_KEY32]{0};
+    std::atomic<int> status_{XXTEA_STATUS_NOT_INITIALIZED};
+};
+
+// values are encrypted and decrypted in place, only 8 and 16 byte values are supported
+int xxtea_encrypt(const XxteaKey &key, uint8_t *data, size_t len);
+int xxtea_decrypt(const XxteaKey &key, uint8_t *data, size_t len);
@@ -0,0 +1,7 @@
+import esphome.codegen as cg
+from esphome.components import esp32_ble_tracker
+
+scanner_ns = cg.esphome_ns.namespace("danfoss_eco_scanner")
+DanfossEcoScanner = scanner_ns.class_(
+    "DanfossEcoScanner", cg.Component, esp32_ble_tracker.ESPBTDeviceListener
+)
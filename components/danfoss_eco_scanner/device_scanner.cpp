@@ -1,3 +1,4 @@
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
 #include "device_scanner.h"
@@ -8,31 +9,111 @@ namespace esphome
 {
     namespace danfoss_eco_scanner
     {
-        static const string eTRV_SUFFIX = string(";eTRV");
+        static const char eTRV_SUFFIX[] = ";eTRV";
+        static const size_t eTRV_SUFFIX_LEN = sizeof(eTRV_SUFFIX) - 1;
+
+        static_assert((AdvertisementTable::CAPACITY & (AdvertisementTable::CAPACITY - 1)) == 0, "CAPACITY should be a power of two");
+        static_assert(AdvertisementTable::CAPACITY == 1 << 6, "slot() should be updated together with CAPACITY");
+
+        Advertisement *AdvertisementTable::insert(uint64_t address, bool &inserted)
+        {
+            inserted = false;
+            if (address == 0)
+                return nullptr; // 0 marks an empty slot
+
+            for (size_t i = slot(address), probes = 0; probes < CAPACITY; i = (i + 1) & (CAPACITY - 1), probes++)
+            {
+                if (this->addresses_[i] == address)
+                    return &this->entries_[i];
+
+                if (this->addresses_[i] == 0)
+                {
+                    this->addresses_[i] = address;
+                    this->entries_[i] = Advertisement();
+                    this->size_++;
+                    inserted = true;
+                    return &this->entries_[i];
+                }
+            }
+            return nullptr;
+        }
+
+        Advertisement *AdvertisementTable::find(uint64_t address)
+        {
+            // a slot, which is not provisioned yet, has no address and would match an empty slot
+            if (address == 0)
+                return nullptr;
+
+            for (size_t i = slot(address), probes = 0; probes < CAPACITY; i = (i + 1) & (CAPACITY - 1), probes++)
+            {
+                if (this->addresses_[i] == address)
+                    return &this->entries_[i];
+                if (this->addresses_[i] == 0)
+                    return nullptr;
+            }
+            return nullptr;
+        }
 
         void DanfossEcoScanner::dump_config()
         {
             ESP_LOGCONFIG(TAG, "Danfoss Eco Scanner:");
             ESP_LOGCONFIG(TAG, "  Read Secret: %d", this->read_secret_);
+            ESP_LOGCONFIG(TAG, "  Known eTRVs: %d/%d", this->advertisements_.size(), AdvertisementTable::CAPACITY);
+        }
+
+        bool DanfossEcoScanner::is_candidate(const ESPBTDevice &device)
+        {
+            // called for every advertisement in range, cheap checks first
+            if ((device.address_uint64() >> 24) == DANFOSS_OUI)
+                return true;
+
+            for (auto &uuid : device.get_service_uuids())
+                if (uuid == DANFOSS_UUID)
+                    return true;
+
+            return false;
         }
 
         bool DanfossEcoScanner::parse_device(const ESPBTDevice &device)
         {
-            string name = device.get_name();
-            int s_len = eTRV_SUFFIX.length();
+            if (!this->is_candidate(device))
+                return false;
 
-            if (name.length() <= s_len || name.compare(name.length() - s_len, s_len, eTRV_SUFFIX) != 0)
+            const string &name = device.get_name();
+            size_t len = name.length();
+            if (len <= eTRV_SUFFIX_LEN || memcmp(name.c_str() + len - eTRV_SUFFIX_LEN, eTRV_SUFFIX, eTRV_SUFFIX_LEN) != 0)
                 return false;
 
-            ESP_LOGI(TAG, "Found Danfoss eTRV, MAC: %s, Name: %s", device.address_str().c_str(), name.c_str());
+            bool inserted;
+            Advertisement *adv = this->advertisements_.insert(device.address_uint64(), inserted);
+            if (adv == nullptr)
+            {
+                if (!this->table_full_logged_)
+                    ESP_LOGW(TAG, "Too many eTRVs in range, ignoring MAC: %s", device.address_str().c_str());
+                this->table_full_logged_ = true;
+                return false;
+            }
+
+            uint8_t flags = (uint8_t)name[0];
+            if (inserted)
+                ESP_LOGI(TAG, "Found Danfoss eTRV, MAC: %s, Name: %s, RSSI: %d", device.address_str().c_str(), name.c_str(), device.get_rssi());
+            else
+                ESP_LOGV(TAG, "Danfoss eTRV advertisement, MAC: %s, RSSI: %d, flags: %#04x", device.address_str().c_str(), device.get_rssi(), flags);
 
-            uint8_t flags = (uint8_t)name.c_str()[0];
-            if ((flags & 0x4) >> 2)
-                ESP_LOGI(TAG, "Ready to read the secret key");
+            if ((flags & FLAG_SECRET_KEY_READABLE) && (inserted || !(adv->flags & FLAG_SECRET_KEY_READABLE)))
+                ESP_LOGI(TAG, "Ready to read the secret key, MAC: %s", device.address_str().c_str());
 
+            adv->last_seen = millis();
+            adv->rssi = device.get_rssi();
+            adv->flags = flags;
             return true;
         }
 
+        const Advertisement *DanfossEcoScanner::get_advertisement(uint64_t address)
+        {
+            return this->advertisements_.find(address);
+        }
+
     } // namespace danfoss_eco_scanner
 } // namespace esphome
 
@@ -13,8 +13,49 @@ namespace esphome
         using namespace esphome::esp32_ble_tracker;
 
         static auto DANFOSS_UUID = ESPBTUUID::from_uint16(0x042f);
+        const uint64_t DANFOSS_OUI = 0x00042f; // first 3 bytes of eTRV MAC addresses
         const char *const TAG = "danfoss_eco_scanner";
 
+        // flags are advertised in the first byte of the eTRV name
+        const uint8_t FLAG_SECRET_KEY_READABLE = 1 << 2; // the hardware button was pressed
+
+        // the latest advertisement of an eTRV
+        struct Advertisement
+        {
+            uint32_t last_seen; // millis
+            int8_t rssi;        // dBm
+            uint8_t flags;
+        };
+
+        // Fixed size open addressing hash table of the eTRVs seen since boot, keyed by the 48 bit MAC address.
+        // Entries are never removed, the table is sized for all eTRVs in the range of a single node.
+        class AdvertisementTable
+        {
+        public:
+            static const size_t CAPACITY = 64; // power of two
+
+            // returns nullptr, if the table is full or the address is 0
+            Advertisement *insert(uint64_t address, bool &inserted);
+            // returns nullptr, if the address was not inserted or is 0
+            Advertisement *find(uint64_t address);
+            size_t size() const { return this->size_; }
+
+            template <typename F>
+            void for_each(F callback) const
+            {
+                for (size_t i = 0; i < CAPACITY; i++)
+                    if (this->addresses_[i] != 0)
+                        callback(this->addresses_[i], this->entries_[i]);
+            }
+
+        private:
+            static size_t slot(uint64_t address) { return (address * 0x9E3779B97F4A7C15ULL) >> (64 - 6); } // fibonacci hashing, 6 = log2(CAPACITY)
+
+            uint64_t addresses_[CAPACITY]{0}; // 0 - empty slot
+            Advertisement entries_[CAPACITY];
+            size_t size_ = 0;
+        };
+
         class DanfossEcoScanner : public ESPBTDeviceListener, public Component
         {
         public:
@@ -25,8 +66,20 @@ namespace esphome
 
             void set_read_secret(bool read_secret) { this->read_secret_ = read_secret; }
 
+            // returns nullptr, if the eTRV was not seen since boot
+            const Advertisement *get_advertisement(uint64_t address);
+
+            // callback(uint64_t address, const Advertisement &) is called for every eTRV seen since boot
+            template <typename F>
+            void for_each_advertisement(F callback) const { this->advertisements_.for_each(callback); }
+
         private:
             bool read_secret_{false};
+
+            bool is_candidate(const ESPBTDevice &device);
+
+            AdvertisementTable advertisements_;
+            bool table_full_logged_{false};
         };
 
     } // namespace danfoss_eco_scanner
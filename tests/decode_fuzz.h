@@ -0,0 +1,130 @@
+#pragma once
+
+#include "device_data.h"
+#include "helpers.h"
+
+#include <cctype>
+#include <cmath>
+#include <vector>
+
+// A single input of the decode/encode fuzzing: the first 16 bytes are the key, the rest is a value received from
+// the device. Values are copied to buffers of their exact length, so a read past the value is caught by ASan.
+// Returns false, if an invariant does not hold.
+namespace fuzz
+{
+    using namespace esphome::danfoss_eco;
+
+    inline bool in_temperature_range(float temperature) { return temperature >= 0 && temperature <= 127.5f; }
+
+    // the decoders are only called with values of the characteristic length, which is checked by the property
+    template <class Data>
+    bool check_length(const std::vector<uint8_t> &value) { return value.size() == Data::LENGTH; }
+
+    inline bool decode_temperature(const std::vector<uint8_t> &value)
+    {
+        if (!check_length<TemperatureData>(value))
+            return true;
+
+        TemperatureData data;
+        data.decode(value.data());
+        if (!data.valid || !in_temperature_range(data.target_temperature) || !in_temperature_range(data.room_temperature))
+            return false;
+
+        // the temperatures are packed back as they were read
+        std::vector<uint8_t> packed(TemperatureData::LENGTH, 0);
+        data.pack(packed.data());
+        return packed[0] == value[0] && packed[1] == value[1];
+    }
+
+    inline bool decode_settings(const std::vector<uint8_t> &value)
+    {
+        if (!check_length<SettingsData>(value))
+            return true;
+
+        SettingsData data;
+        data.decode(value.data());
+        if (!data.valid || data.has_changes())
+            return false;
+        if (!in_temperature_range(data.temperature_min) || !in_temperature_range(data.temperature_max) ||
+            !in_temperature_range(data.frost_protection_temperature) || !in_temperature_range(data.vacation_temperature))
+            return false;
+        if (data.device_mode != ClimateMode::CLIMATE_MODE_HEAT && data.device_mode != ClimateMode::CLIMATE_MODE_AUTO)
+            return false;
+
+        // settings are written back as a whole, fields which are not decoded must survive
+        std::vector<uint8_t> packed(SettingsData::LENGTH, 0);
+        data.pack(packed.data());
+        if (packed != value)
+            return false;
+
+        // a change only touches its own field, out of range values are clamped
+        data.set_temperature_min(value[0] * 2.0f - 100);
+        data.pack(packed.data());
+        for (size_t i = 0; i < SettingsData::LENGTH; i++)
+            if (i != 1 && packed[i] != value[i])
+                return false;
+        return in_temperature_range(data.temperature_min);
+    }
+
+    inline bool decode_errors(const std::vector<uint8_t> &value)
+    {
+        if (!check_length<ErrorsData>(value))
+            return true;
+
+        ErrorsData data;
+        data.decode(value.data());
+        return data.valid && data.E9_VALVE_DOES_NOT_CLOSE == ((value[0] & 0x01) != 0);
+    }
+
+    inline bool parse_hex(const uint8_t *data, size_t size)
+    {
+        const char *str = (const char *)data;
+        bool hex = size % 2 == 0;
+        for (size_t i = 0; i < size; i++)
+            hex = hex && isxdigit(data[i]);
+
+        std::vector<uint8_t> parsed(size / 2 + 1);
+        if (parse_hex_str(str, size, parsed.data()) != hex)
+            return false;
+        if (!hex)
+            return true;
+
+        // parsed values are encoded back to the same digits
+        std::vector<char> encoded(size + 1);
+        encode_hex(parsed.data(), size / 2, encoded.data());
+        for (size_t i = 0; i < size; i++)
+            if (encoded[i] != tolower(str[i]))
+                return false;
+        return true;
+    }
+
+    inline bool fuzz_one(const uint8_t *data, size_t size)
+    {
+        if (!parse_hex(data, size))
+            return false;
+
+        size_t key_len = size < 16 ? size : 16;
+        XxteaKey key;
+        bool key_set = key.set(key_len > 0 ? data : nullptr, key_len) == XXTEA_STATUS_SUCCESS;
+        if (key_set != (key_len > 0))
+            return false;
+
+        std::vector<uint8_t> value(data + key_len, data + size);
+        std::vector<uint8_t> plain(value);
+
+        // only 8 and 16 byte values are encrypted, any other length is rejected
+        bool supported = key_set && (value.size() == 8 || value.size() == 16);
+        if (decrypt(key, value.data(), value.size()) != supported)
+            return false;
+
+        if (!decode_temperature(value) || !decode_settings(value) || !decode_errors(value))
+            return false;
+
+        if (supported)
+        {
+            if (!encrypt(key, value.data(), value.size()) || value != plain)
+                return false;
+        }
+        return true;
+    }
+} // namespace fuzz
@@ -0,0 +1,11 @@
+#include "decode_fuzz.h"
+
+#include <cstdlib>
+
+// libFuzzer entry, see decode_test.cpp
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (!fuzz::fuzz_one(data, size))
+        abort();
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "decode_fuzz.h"
+
+#include "test.h"
+
+#include <random>
+
+// Random and truncated values through XxteaKey, decrypt() and every decoder, with the invariants of fuzz_one().
+// decode_fuzzer runs the same checks with coverage guided inputs, when the tests are built with clang.
+
+static void test_random(std::mt19937 &random)
+{
+    for (int i = 0; i < 200000; i++)
+    {
+        // lengths around the key and the characteristic lengths are the interesting ones
+        size_t size = random() % 48;
+        std::vector<uint8_t> data(size);
+        for (auto &b : data)
+            b = random();
+
+        if (!fuzz::fuzz_one(data.data(), data.size()))
+        {
+            fprintf(stderr, "invariant failed, input length=%zu\n", size);
+            CHECK(false);
+            return;
+        }
+    }
+}
+
+// every prefix of a valid input, down to an empty one
+static void test_truncated(std::mt19937 &random)
+{
+    for (size_t value_len : {8, 16})
+    {
+        std::vector<uint8_t> data(16 + value_len);
+        for (auto &b : data)
+            b = random();
+
+        for (size_t size = data.size() + 1; size-- > 0;)
+        {
+            std::vector<uint8_t> truncated(data.begin(), data.begin() + size);
+            CHECK(fuzz::fuzz_one(truncated.data(), truncated.size()));
+        }
+    }
+}
+
+static void test_hex(std::mt19937 &random)
+{
+    static const char CHARS[] = "0123456789abcdefABCDEFgG :\xff";
+    for (int i = 0; i < 20000; i++)
+    {
+        std::vector<uint8_t> str(random() % 40);
+        for (auto &c : str)
+            c = CHARS[random() % (sizeof(CHARS) - 1)];
+        CHECK(fuzz::fuzz_one(str.data(), str.size()));
+    }
+}
+
+int main()
+{
+    std::mt19937 random(1);
+    test_random(random);
+    test_truncated(random);
+    test_hex(random);
+    return test_result("decode_test");
+}
@@ -0,0 +1,177 @@
+#include "etrv_simulator.h"
+
+#include "esphome/components/sensor/sensor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Load test of a node polling N simulated eTRVs: polls/min, connect-to-publish latency and the session failure rate,
+// under the injected latency, dropped responses, GATT errors and lost links. Every poll publishes (max_silence = 0).
+//
+//   etrv_benchmark --devices 20 --minutes 60 --drop 0.02 --errors 0.01
+
+using namespace esphome;
+
+struct Options
+{
+    size_t devices = 10;
+    uint32_t minutes = 60;
+    uint32_t update_interval = 60000;
+    uint8_t max_connections = 1;
+    size_t clients = 1;
+    uint32_t connection_gap = 2000;
+    uint8_t pipeline_depth = 2;
+    uint32_t seed = 1;
+    bool verbose = false;
+    sim::Faults faults;
+};
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [--devices N] [--minutes N] [--update-interval MS] [--max-connections N] [--clients N]\n"
+            "          [--connection-gap MS] [--pipeline-depth N] [--latency MS] [--jitter MS] [--drop RATE]\n"
+            "          [--errors RATE] [--error-status STATUS] [--connect-failures RATE] [--link-loss RATE]\n"
+            "          [--seed N] [--verbose]\n",
+            name);
+}
+
+static bool parse(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--verbose")
+        {
+            options.verbose = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return false;
+
+        const char *value = argv[++i];
+        if (arg == "--devices")
+            options.devices = strtoul(value, nullptr, 0);
+        else if (arg == "--minutes")
+            options.minutes = strtoul(value, nullptr, 0);
+        else if (arg == "--update-interval")
+            options.update_interval = strtoul(value, nullptr, 0);
+        else if (arg == "--max-connections")
+            options.max_connections = strtoul(value, nullptr, 0);
+        else if (arg == "--clients")
+            options.clients = strtoul(value, nullptr, 0);
+        else if (arg == "--connection-gap")
+            options.connection_gap = strtoul(value, nullptr, 0);
+        else if (arg == "--pipeline-depth")
+            options.pipeline_depth = strtoul(value, nullptr, 0);
+        else if (arg == "--latency")
+            options.faults.latency = strtoul(value, nullptr, 0);
+        else if (arg == "--jitter")
+            options.faults.jitter = strtoul(value, nullptr, 0);
+        else if (arg == "--drop")
+            options.faults.drop_rate = strtof(value, nullptr);
+        else if (arg == "--errors")
+            options.faults.error_rate = strtof(value, nullptr);
+        else if (arg == "--error-status")
+            options.faults.error_status = (esp_gatt_status_t)strtoul(value, nullptr, 0);
+        else if (arg == "--connect-failures")
+            options.faults.connect_failure_rate = strtof(value, nullptr);
+        else if (arg == "--link-loss")
+            options.faults.link_loss_rate = strtof(value, nullptr);
+        else if (arg == "--seed")
+            options.seed = strtoul(value, nullptr, 0);
+        else
+            return false;
+    }
+    return options.devices > 0 && options.minutes > 0 && options.clients > 0 && options.max_connections > 0;
+}
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, uint8_t p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t rank = (p * sorted.size() + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parse(argc, argv, options))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (options.verbose)
+        host_log_level = ESPHOME_LOG_LEVEL_DEBUG;
+
+    sim::Simulator sim(options.seed);
+    sim.faults = options.faults;
+
+    sim::Node node(options.clients, options.max_connections);
+    node.scheduler->set_connection_gap(options.connection_gap);
+
+    uint32_t polls = 0;
+    uint32_t sessions = 0;
+    uint32_t failures = 0;
+    std::vector<uint32_t> latencies;
+
+    for (size_t i = 0; i < options.devices; i++)
+    {
+        auto &etrv = sim.add_etrv(0x00046f000000 + i);
+        etrv.room_temperature = 18 + (i % 8) / 2.0f;
+
+        auto *device = node.add_device(etrv, "etrv_" + std::to_string(i));
+        device->set_update_interval(options.update_interval);
+        device->set_pipeline_depth(options.pipeline_depth);
+        device->set_max_silence(0);
+
+        // from the connection attempt of the session to the publish of the climate state
+        device->add_on_state_callback([&polls, &latencies, &etrv](climate::Climate &)
+                                      {
+                                          polls++;
+                                          latencies.push_back(App.get_time() - etrv.last_open);
+                                      });
+
+        auto *duration = new sensor::Sensor();
+        duration->add_on_state_callback([&sessions](float)
+                                        { sessions++; });
+        device->set_session_duration(duration);
+
+        auto *failed = new sensor::Sensor();
+        failed->add_on_state_callback([&sessions, &failures](float)
+                                      {
+                                          sessions++;
+                                          failures++;
+                                      });
+        device->set_session_failures(failed);
+    }
+
+    sim.setup();
+    sim.run_until(options.minutes * 60000);
+
+    std::sort(latencies.begin(), latencies.end());
+    uint64_t latency_total = 0;
+    for (auto latency : latencies)
+        latency_total += latency;
+
+    double expected = (double)options.devices * options.minutes * 60000 / options.update_interval;
+    printf("devices: %zu, clients: %zu, max connections: %d, update interval: %u ms, simulated: %u min\n",
+           options.devices, options.clients, options.max_connections, options.update_interval, options.minutes);
+    printf("faults: latency=%u+%u ms, drop=%.3f, errors=%.3f (status %#04x), connect failures=%.3f, link loss=%.3f\n",
+           options.faults.latency, options.faults.jitter, options.faults.drop_rate, options.faults.error_rate,
+           options.faults.error_status, options.faults.connect_failure_rate, options.faults.link_loss_rate);
+    printf("polls: %u (%.1f/min, %.0f%% of the update interval)\n", polls, polls / (double)options.minutes, polls * 100.0 / expected);
+    printf("connect-to-publish latency: avg=%u ms, p50=%u ms, p95=%u ms, max=%u ms\n",
+           latencies.empty() ? 0 : (uint32_t)(latency_total / latencies.size()),
+           percentile(latencies, 50), percentile(latencies, 95), latencies.empty() ? 0 : latencies.back());
+    printf("sessions: %u, failed: %u (%.1f%%)\n", sessions, failures, sessions > 0 ? failures * 100.0 / sessions : 0.0);
+    printf("injected: opens=%u, open failures=%u, requests=%u, read-multiple=%u, dropped=%u, errors=%u, link losses=%u\n",
+           sim.stats.opens, sim.stats.open_failures, sim.stats.requests, sim.stats.read_multiple, sim.stats.dropped,
+           sim.stats.errors, sim.stats.link_losses);
+    return EXIT_SUCCESS;
+}
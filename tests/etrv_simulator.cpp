@@ -0,0 +1,659 @@
+#include "etrv_simulator.h"
+#include "reference_xxtea.h"
+
+#include "esphome/core/preferences.h"
+
+#include <esp_gap_ble_api.h>
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace esphome;
+
+namespace sim
+{
+    Simulator *Simulator::current_ = nullptr;
+
+    struct CharacteristicDef
+    {
+        esp_bt_uuid_t uuid;
+        uint16_t handle;
+    };
+
+    struct ServiceDef
+    {
+        esp_bt_uuid_t uuid;
+        uint16_t start_handle;
+        uint16_t end_handle;
+    };
+
+    static esp_bt_uuid_t uuid16(uint16_t uuid)
+    {
+        return esp32_ble_tracker::ESPBTUUID::from_uint16(uuid).get_uuid();
+    }
+
+    static esp_bt_uuid_t uuid128(const char *uuid)
+    {
+        return esp32_ble_tracker::ESPBTUUID::from_raw(uuid).get_uuid();
+    }
+
+    // GATT database of the eTRV firmware, only the services and characteristics used by the component
+    static const ServiceDef SERVICE_BATTERY = {uuid16(0x180F), 0x0e, 0x11};
+    static const ServiceDef SERVICE_SETTINGS = {uuid128("10020000-2749-0001-0000-00805f9b042f"), 0x20, 0x40};
+
+    static const CharacteristicDef CHARACTERISTICS[] = {
+        {uuid16(0x2A19), HANDLE_BATTERY},
+        {uuid128("10020001-2749-0001-0000-00805f9b042f"), HANDLE_PIN},
+        {uuid128("10020003-2749-0001-0000-00805f9b042f"), HANDLE_SETTINGS},
+        {uuid128("10020005-2749-0001-0000-00805f9b042f"), HANDLE_TEMPERATURE},
+        {uuid128("10020009-2749-0001-0000-00805f9b042f"), HANDLE_ERRORS},
+        {uuid128("1002000b-2749-0001-0000-00805f9b042f"), HANDLE_SECRET_KEY},
+    };
+
+    Etrv::Etrv(uint64_t address, std::mt19937 &rng) : address(address)
+    {
+        for (auto &b : this->key)
+            b = rng();
+
+        // valve installed, 5 - 28 °C, frost protection at 7 °C, manual mode, vacation at 15 °C
+        const uint8_t defaults[16] = {0x40, 10, 56, 14, 0, 30};
+        memcpy(this->settings, defaults, sizeof(this->settings));
+    }
+
+    esp_gatt_status_t Etrv::read(uint16_t handle, bool authorized, std::vector<uint8_t> &value)
+    {
+        this->reads++;
+        if (handle == HANDLE_BATTERY)
+        {
+            value = {this->battery};
+            return ESP_GATT_OK;
+        }
+        if (handle == HANDLE_PIN)
+            return ESP_GATT_READ_NOT_PERMIT;
+        if (handle == HANDLE_SECRET_KEY)
+        {
+            if (!this->button_pressed)
+                return ESP_GATT_INVALID_HANDLE;
+            value.assign(this->key, this->key + sizeof(this->key));
+            return ESP_GATT_OK;
+        }
+
+        if (handle == HANDLE_TEMPERATURE)
+            value = {(uint8_t)(this->target_temperature * 2), (uint8_t)(this->room_temperature * 2), 0, 0, 0, 0, 0, 0};
+        else if (handle == HANDLE_SETTINGS)
+            value.assign(this->settings, this->settings + sizeof(this->settings));
+        else if (handle == HANDLE_ERRORS)
+            value.assign(this->errors, this->errors + sizeof(this->errors));
+        else
+            return ESP_GATT_INVALID_HANDLE;
+
+        // the encrypted values are only served once the PIN was accepted
+        if (!authorized)
+        {
+            value.clear();
+            return ESP_GATT_INSUF_AUTHORIZATION;
+        }
+
+        reference::crypt(this->key, value.data(), value.size(), true);
+        return ESP_GATT_OK;
+    }
+
+    esp_gatt_status_t Etrv::write(uint16_t handle, const uint8_t *value, uint16_t value_len, bool &authorized)
+    {
+        this->writes++;
+        if (handle == HANDLE_PIN)
+        {
+            if (value_len != 4)
+                return ESP_GATT_INVALID_ATTR_LEN;
+            uint32_t pin = (uint32_t)value[0] << 24 | value[1] << 16 | value[2] << 8 | value[3];
+            if (pin != this->pin_code)
+                return ESP_GATT_INSUF_AUTHENTICATION;
+            authorized = true;
+            return ESP_GATT_OK;
+        }
+
+        uint8_t plain[16];
+        if (handle == HANDLE_TEMPERATURE || handle == HANDLE_SETTINGS)
+        {
+            if (!authorized)
+                return ESP_GATT_INSUF_AUTHORIZATION;
+            if (value_len != (handle == HANDLE_TEMPERATURE ? 8 : 16))
+                return ESP_GATT_INVALID_ATTR_LEN;
+
+            memcpy(plain, value, value_len);
+            reference::crypt(this->key, plain, value_len, false);
+        }
+
+        if (handle == HANDLE_TEMPERATURE)
+            this->target_temperature = plain[0] / 2.0f;
+        else if (handle == HANDLE_SETTINGS)
+            memcpy(this->settings, plain, sizeof(this->settings));
+        else if (handle == HANDLE_BATTERY || handle == HANDLE_ERRORS || handle == HANDLE_SECRET_KEY)
+            return ESP_GATT_WRITE_NOT_PERMIT;
+        else
+            return ESP_GATT_INVALID_HANDLE;
+        return ESP_GATT_OK;
+    }
+
+    std::string Etrv::secret_key() const
+    {
+        char buff[sizeof(this->key) * 2 + 1];
+        for (size_t i = 0; i < sizeof(this->key); i++)
+            sprintf(buff + i * 2, "%02x", this->key[i]);
+        return buff;
+    }
+
+    Simulator::Simulator(uint32_t seed) : rng_(seed)
+    {
+        current_ = this;
+        App.reset();
+        global_preferences->reset();
+    }
+
+    Simulator::~Simulator()
+    {
+        if (current_ == this)
+            current_ = nullptr;
+    }
+
+    Etrv &Simulator::add_etrv(uint64_t address)
+    {
+        this->etrvs_.push_back(std::unique_ptr<Etrv>(new Etrv(address, this->rng_)));
+        return *this->etrvs_.back();
+    }
+
+    Etrv *Simulator::find_etrv(const uint8_t *bda)
+    {
+        uint64_t address = 0;
+        for (int i = 0; i < ESP_BD_ADDR_LEN; i++)
+            address = address << 8 | bda[i];
+
+        for (auto &etrv : this->etrvs_)
+            if (etrv->address == address)
+                return etrv.get();
+        return nullptr;
+    }
+
+    void Simulator::setup()
+    {
+        App.setup();
+        this->next_loop_ = App.get_time();
+    }
+
+    void Simulator::run_until(uint32_t time)
+    {
+        for (;;)
+        {
+            // events, which are due by the next loop, are delivered first: the BT task runs in parallel to the main loop
+            if (!this->events_.empty() && this->events_.top().at <= this->next_loop_ && this->events_.top().at <= time)
+            {
+                Event event = this->events_.top();
+                this->events_.pop();
+                App.set_time(std::max(App.get_time(), event.at));
+
+                auto it = this->links_.find(event.gattc_if);
+                if (event.gattc_if == ESP_GATT_IF_NONE || (it != this->links_.end() && it->second.generation == event.generation))
+                    event.deliver();
+                continue;
+            }
+
+            if (this->next_loop_ > time)
+                break;
+
+            App.set_time(this->next_loop_);
+            App.loop();
+            this->next_loop_ += this->loop_interval;
+        }
+        App.set_time(time);
+    }
+
+    uint32_t Simulator::delay(uint32_t latency)
+    {
+        if (this->faults.jitter == 0)
+            return latency;
+        return latency + this->rng_() % (this->faults.jitter + 1);
+    }
+
+    void Simulator::schedule(uint32_t at, esp_gatt_if_t gattc_if, std::function<void()> deliver)
+    {
+        uint32_t generation = gattc_if != ESP_GATT_IF_NONE ? this->links_[gattc_if].generation : 0;
+        this->events_.push({at, this->seq_++, gattc_if, generation, std::move(deliver)});
+    }
+
+    void Simulator::dispatch(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t &param)
+    {
+        esp32_ble_tracker::global_esp32_ble_tracker->gattc_event_handler(event, gattc_if, &param);
+    }
+
+    void Simulator::broadcast(esp_gattc_cb_event_t event, esp_ble_gattc_cb_param_t &param)
+    {
+        std::vector<esp_gatt_if_t> interfaces;
+        for (auto &link : this->links_)
+            interfaces.push_back(link.first);
+
+        for (auto gattc_if : interfaces)
+        {
+            esp_ble_gattc_cb_param_t copy = param;
+            this->dispatch(event, gattc_if, copy);
+        }
+    }
+
+    Simulator::Link *Simulator::find_link(esp_gatt_if_t gattc_if, uint16_t conn_id)
+    {
+        auto it = this->links_.find(gattc_if);
+        if (it == this->links_.end() || it->second.state != LinkState::OPEN || it->second.conn_id != conn_id)
+            return nullptr;
+        return &it->second;
+    }
+
+    esp_err_t Simulator::app_register(uint16_t app_id)
+    {
+        esp_gatt_if_t gattc_if = this->next_gattc_if_++;
+        this->links_[gattc_if] = Link();
+
+        this->schedule(App.get_time(), gattc_if, [this, gattc_if, app_id]()
+                       {
+                           esp_ble_gattc_cb_param_t param = {};
+                           param.reg.status = ESP_GATT_OK;
+                           param.reg.app_id = app_id;
+                           this->dispatch(ESP_GATTC_REG_EVT, gattc_if, param);
+                       });
+        return ESP_OK;
+    }
+
+    esp_err_t Simulator::open(esp_gatt_if_t gattc_if, const uint8_t *bda)
+    {
+        auto it = this->links_.find(gattc_if);
+        if (it == this->links_.end() || it->second.state != LinkState::IDLE)
+            return ESP_FAIL;
+
+        Link &link = it->second;
+        link = {LinkState::OPENING, this->find_etrv(bda), ++this->next_conn_id_, link.generation + 1};
+        this->stats.opens++;
+
+        uint32_t now = App.get_time();
+        esp_ble_gattc_cb_param_t param = {};
+        param.open.conn_id = link.conn_id;
+        memcpy(param.open.remote_bda, bda, ESP_BD_ADDR_LEN);
+        param.open.mtu = ESP_GATT_DEF_BLE_MTU_SIZE;
+
+        if (link.etrv != nullptr)
+            link.etrv->last_open = now;
+
+        // nothing answers the connection request of an eTRV, which is out of range
+        bool reachable = link.etrv != nullptr && link.etrv->present;
+        if (!reachable || this->chance(this->faults.connect_failure_rate))
+        {
+            this->stats.open_failures++;
+            param.open.status = ESP_GATT_ERROR;
+            uint32_t at = now + (reachable ? this->delay(this->faults.connect_latency) : this->faults.connect_timeout);
+            this->schedule(at, gattc_if, [this, gattc_if, param]() mutable
+                           {
+                               this->links_[gattc_if].state = LinkState::IDLE;
+                               this->dispatch(ESP_GATTC_OPEN_EVT, gattc_if, param);
+                           });
+            return ESP_OK;
+        }
+
+        this->schedule(now + this->delay(this->faults.connect_latency), gattc_if, [this, gattc_if, param]() mutable
+                       {
+                           this->links_[gattc_if].state = LinkState::OPEN;
+
+                           esp_ble_gattc_cb_param_t connect = {};
+                           connect.connect.conn_id = param.open.conn_id;
+                           memcpy(connect.connect.remote_bda, param.open.remote_bda, ESP_BD_ADDR_LEN);
+                           this->broadcast(ESP_GATTC_CONNECT_EVT, connect);
+
+                           param.open.status = ESP_GATT_OK;
+                           this->dispatch(ESP_GATTC_OPEN_EVT, gattc_if, param);
+                       });
+        return ESP_OK;
+    }
+
+    esp_err_t Simulator::close(esp_gatt_if_t gattc_if, uint16_t conn_id)
+    {
+        auto it = this->links_.find(gattc_if);
+        if (it == this->links_.end() || it->second.conn_id != conn_id)
+            return ESP_FAIL;
+
+        Link &link = it->second;
+        switch (link.state)
+        {
+        case LinkState::OPENING:
+        {
+            // the pending connection is cancelled, the client learns about it from the failed open
+            link.generation++;
+            link.state = LinkState::CLOSING;
+
+            esp_ble_gattc_cb_param_t param = {};
+            param.open.status = ESP_GATT_ERROR;
+            param.open.conn_id = conn_id;
+            this->schedule(App.get_time() + this->delay(this->faults.latency), gattc_if, [this, gattc_if, param]() mutable
+                           {
+                               this->links_[gattc_if].state = LinkState::IDLE;
+                               this->dispatch(ESP_GATTC_OPEN_EVT, gattc_if, param);
+                           });
+            return ESP_OK;
+        }
+
+        case LinkState::OPEN:
+            this->close_link(gattc_if, ESP_GATT_CONN_TERMINATE_LOCAL_HOST);
+            return ESP_OK;
+
+        default:
+            return ESP_FAIL;
+        }
+    }
+
+    void Simulator::close_link(esp_gatt_if_t gattc_if, esp_gatt_conn_reason_t reason)
+    {
+        Link &link = this->links_[gattc_if];
+        link.generation++; // responses of this connection are never delivered
+        link.state = LinkState::CLOSING;
+        link.authorized = false;
+
+        esp_ble_gattc_cb_param_t param = {};
+        param.disconnect.reason = reason;
+        param.disconnect.conn_id = link.conn_id;
+        for (int i = 0; i < ESP_BD_ADDR_LEN; i++)
+            param.disconnect.remote_bda[i] = link.etrv->address >> (8 * (ESP_BD_ADDR_LEN - 1 - i));
+
+        this->schedule(App.get_time() + this->delay(this->faults.latency), gattc_if, [this, gattc_if, param]() mutable
+                       {
+                           this->links_[gattc_if].state = LinkState::IDLE;
+                           this->broadcast(ESP_GATTC_DISCONNECT_EVT, param);
+
+                           esp_ble_gattc_cb_param_t close = {};
+                           close.close.status = ESP_GATT_OK;
+                           close.close.conn_id = param.disconnect.conn_id;
+                           memcpy(close.close.remote_bda, param.disconnect.remote_bda, ESP_BD_ADDR_LEN);
+                           close.close.reason = param.disconnect.reason;
+                           this->dispatch(ESP_GATTC_CLOSE_EVT, gattc_if, close);
+                       });
+    }
+
+    esp_err_t Simulator::send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id)
+    {
+        Link *link = this->find_link(gattc_if, conn_id);
+        if (link == nullptr)
+            return ESP_FAIL;
+
+        link->mtu = link->etrv->mtu;
+        esp_ble_gattc_cb_param_t param = {};
+        param.cfg_mtu.status = ESP_GATT_OK;
+        param.cfg_mtu.conn_id = conn_id;
+        param.cfg_mtu.mtu = link->mtu;
+        this->schedule(App.get_time() + this->delay(this->faults.latency), gattc_if, [this, gattc_if, param]() mutable
+                       { this->dispatch(ESP_GATTC_CFG_MTU_EVT, gattc_if, param); });
+        return ESP_OK;
+    }
+
+    esp_err_t Simulator::search_service(esp_gatt_if_t gattc_if, uint16_t conn_id)
+    {
+        if (this->find_link(gattc_if, conn_id) == nullptr)
+            return ESP_FAIL;
+
+        esp_ble_gattc_cb_param_t param = {};
+        param.search_cmpl.status = ESP_GATT_OK;
+        param.search_cmpl.conn_id = conn_id;
+        this->schedule(App.get_time() + this->delay(this->faults.discovery_latency), gattc_if, [this, gattc_if, param]() mutable
+                       { this->dispatch(ESP_GATTC_SEARCH_CMPL_EVT, gattc_if, param); });
+        return ESP_OK;
+    }
+
+    esp_gatt_status_t Simulator::get_service(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_gattc_service_elem_t *result, uint16_t *count, uint16_t offset)
+    {
+        if (this->find_link(gattc_if, conn_id) == nullptr)
+            return ESP_GATT_ERROR;
+
+        const ServiceDef *services[] = {&SERVICE_BATTERY, &SERVICE_SETTINGS};
+        if (offset >= sizeof(services) / sizeof(services[0]))
+        {
+            *count = 0;
+            return ESP_GATT_INVALID_OFFSET;
+        }
+
+        *result = {true, services[offset]->start_handle, services[offset]->end_handle, services[offset]->uuid};
+        *count = 1;
+        return ESP_GATT_OK;
+    }
+
+    esp_gatt_status_t Simulator::get_all_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t start_handle, uint16_t end_handle,
+                                              esp_gattc_char_elem_t *result, uint16_t *count, uint16_t offset)
+    {
+        Link *link = this->find_link(gattc_if, conn_id);
+        if (link == nullptr)
+            return ESP_GATT_ERROR;
+
+        // the secret key characteristic is only exposed for a while after the hardware button was pressed
+        uint16_t found = 0;
+        for (auto &chr : CHARACTERISTICS)
+        {
+            if (chr.handle < start_handle || chr.handle > end_handle || (chr.handle == HANDLE_SECRET_KEY && !link->etrv->button_pressed))
+                continue;
+            if (found++ == offset)
+            {
+                *result = {chr.handle, ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE, chr.uuid};
+                *count = 1;
+                return ESP_GATT_OK;
+            }
+        }
+
+        *count = 0;
+        return ESP_GATT_INVALID_OFFSET;
+    }
+
+    bool Simulator::request(esp_gatt_if_t gattc_if, uint32_t &at, esp_gatt_status_t &status)
+    {
+        Link &link = this->links_[gattc_if];
+        this->stats.requests++;
+
+        at = std::max(App.get_time(), link.busy_until) + this->delay(this->faults.latency);
+        link.busy_until = at;
+        status = ESP_GATT_OK;
+
+        if (this->chance(this->faults.link_loss_rate))
+        {
+            this->stats.link_losses++;
+            uint32_t generation = link.generation;
+            this->schedule(at, gattc_if, [this, gattc_if, generation]()
+                           {
+                               if (this->links_[gattc_if].generation == generation)
+                                   this->close_link(gattc_if, ESP_GATT_CONN_TIMEOUT);
+                           });
+            return false;
+        }
+
+        if (this->chance(this->faults.drop_rate))
+        {
+            this->stats.dropped++;
+            return false;
+        }
+
+        if (this->chance(this->faults.error_rate))
+        {
+            this->stats.errors++;
+            status = this->faults.error_status;
+        }
+        return true;
+    }
+
+    esp_err_t Simulator::read_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle)
+    {
+        if (this->find_link(gattc_if, conn_id) == nullptr)
+            return ESP_FAIL;
+
+        uint32_t at;
+        esp_gatt_status_t status;
+        if (!this->request(gattc_if, at, status))
+            return ESP_OK;
+
+        this->schedule(at, gattc_if, [this, gattc_if, conn_id, handle, status]()
+                       {
+                           Link &link = this->links_[gattc_if];
+                           std::vector<uint8_t> value;
+                           esp_ble_gattc_cb_param_t param = {};
+                           param.read.status = status != ESP_GATT_OK ? status : link.etrv->read(handle, link.authorized, value);
+                           param.read.conn_id = conn_id;
+                           param.read.handle = handle;
+                           param.read.value = value.data();
+                           param.read.value_len = param.read.status == ESP_GATT_OK ? value.size() : 0;
+                           this->dispatch(ESP_GATTC_READ_CHAR_EVT, gattc_if, param);
+                       });
+        return ESP_OK;
+    }
+
+    esp_err_t Simulator::read_multiple(esp_gatt_if_t gattc_if, uint16_t conn_id, const esp_gattc_multi_t *read_multi)
+    {
+        if (this->find_link(gattc_if, conn_id) == nullptr || read_multi->num_attr > ESP_GATT_MAX_READ_MULTI_HANDLES)
+            return ESP_FAIL;
+
+        uint32_t at;
+        esp_gatt_status_t status;
+        this->stats.read_multiple++;
+        if (!this->request(gattc_if, at, status))
+            return ESP_OK;
+
+        std::vector<uint16_t> handles(read_multi->handles, read_multi->handles + read_multi->num_attr);
+        this->schedule(at, gattc_if, [this, gattc_if, conn_id, handles, status]()
+                       {
+                           Link &link = this->links_[gattc_if];
+                           esp_ble_gattc_cb_param_t param = {};
+                           param.read.conn_id = conn_id;
+                           param.read.status = status;
+
+                           std::vector<uint8_t> values;
+                           if (status == ESP_GATT_OK && !link.etrv->read_multiple)
+                               param.read.status = ESP_GATT_REQ_NOT_SUPPORTED;
+                           for (size_t i = 0; i < handles.size() && param.read.status == ESP_GATT_OK; i++)
+                           {
+                               std::vector<uint8_t> value;
+                               param.read.status = link.etrv->read(handles[i], link.authorized, value);
+                               values.insert(values.end(), value.begin(), value.end());
+                           }
+
+                           // ATT truncates the response to the MTU
+                           if (values.size() > link.mtu - 1u)
+                               values.resize(link.mtu - 1);
+                           param.read.value = values.data();
+                           param.read.value_len = param.read.status == ESP_GATT_OK ? values.size() : 0;
+                           this->dispatch(ESP_GATTC_READ_MULTIPLE_EVT, gattc_if, param);
+                       });
+        return ESP_OK;
+    }
+
+    esp_err_t Simulator::write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t value_len, const uint8_t *value)
+    {
+        if (this->find_link(gattc_if, conn_id) == nullptr)
+            return ESP_FAIL;
+
+        uint32_t at;
+        esp_gatt_status_t status;
+        if (!this->request(gattc_if, at, status))
+            return ESP_OK;
+
+        std::vector<uint8_t> data(value, value + value_len);
+        this->schedule(at, gattc_if, [this, gattc_if, conn_id, handle, data, status]()
+                       {
+                           Link &link = this->links_[gattc_if];
+                           esp_ble_gattc_cb_param_t param = {};
+                           param.write.status = status != ESP_GATT_OK ? status : link.etrv->write(handle, data.data(), data.size(), link.authorized);
+                           param.write.conn_id = conn_id;
+                           param.write.handle = handle;
+                           this->dispatch(ESP_GATTC_WRITE_CHAR_EVT, gattc_if, param);
+                       });
+        return ESP_OK;
+    }
+
+    Node::Node(size_t clients, uint8_t max_connections)
+    {
+        this->tracker = new esp32_ble_tracker::ESP32BLETracker();
+        App.register_component(this->tracker);
+
+        this->scheduler = new danfoss_eco::ConnectionScheduler();
+        App.register_component(this->scheduler);
+        this->scheduler->set_max_connections(max_connections);
+
+        for (size_t i = 0; i < clients; i++)
+        {
+            auto *client = new ble_client::BLEClient();
+            App.register_component(client);
+            this->scheduler->add_client(client);
+            this->clients.push_back(client);
+        }
+    }
+
+    danfoss_eco::Device *Node::add_device(const Etrv &etrv, const std::string &name, bool with_key)
+    {
+        auto *device = new danfoss_eco::Device();
+        App.register_component(device);
+        device->set_name(name);
+        device->set_update_interval(60000);
+        device->set_pooled(true);
+        device->set_mac_address(etrv.address);
+
+        this->scheduler->register_device(device);
+        device->set_scheduler(this->scheduler);
+
+        device->set_secret_key(with_key ? etrv.secret_key() : "");
+        device->set_pin_code(std::to_string(etrv.pin_code));
+
+        this->devices.push_back(device);
+        return device;
+    }
+} // namespace sim
+
+// ESP-IDF calls of ble_client and of the component, answered by the current simulator
+
+esp_err_t esp_ble_gattc_app_register(uint16_t app_id) { return sim::Simulator::instance()->app_register(app_id); }
+
+esp_err_t esp_ble_gattc_open(esp_gatt_if_t gattc_if, esp_bd_addr_t remote_bda, esp_ble_addr_type_t remote_addr_type, bool is_direct)
+{
+    return sim::Simulator::instance()->open(gattc_if, remote_bda);
+}
+
+esp_err_t esp_ble_gattc_close(esp_gatt_if_t gattc_if, uint16_t conn_id) { return sim::Simulator::instance()->close(gattc_if, conn_id); }
+
+esp_err_t esp_ble_gattc_send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id) { return sim::Simulator::instance()->send_mtu_req(gattc_if, conn_id); }
+
+esp_err_t esp_ble_gattc_search_service(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_bt_uuid_t *filter_uuid)
+{
+    return sim::Simulator::instance()->search_service(gattc_if, conn_id);
+}
+
+esp_gatt_status_t esp_ble_gattc_get_service(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_bt_uuid_t *svc_uuid,
+                                            esp_gattc_service_elem_t *result, uint16_t *count, uint16_t offset)
+{
+    return sim::Simulator::instance()->get_service(gattc_if, conn_id, result, count, offset);
+}
+
+esp_gatt_status_t esp_ble_gattc_get_all_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t start_handle, uint16_t end_handle,
+                                             esp_gattc_char_elem_t *result, uint16_t *count, uint16_t offset)
+{
+    return sim::Simulator::instance()->get_all_char(gattc_if, conn_id, start_handle, end_handle, result, count, offset);
+}
+
+esp_err_t esp_ble_gattc_read_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, esp_gatt_auth_req_t auth_req)
+{
+    return sim::Simulator::instance()->read_char(gattc_if, conn_id, handle);
+}
+
+esp_err_t esp_ble_gattc_read_multiple(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_gattc_multi_t *read_multi, esp_gatt_auth_req_t auth_req)
+{
+    return sim::Simulator::instance()->read_multiple(gattc_if, conn_id, read_multi);
+}
+
+esp_err_t esp_ble_gattc_write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t value_len, uint8_t *value,
+                                   esp_gatt_write_type_t write_type, esp_gatt_auth_req_t auth_req)
+{
+    return sim::Simulator::instance()->write_char(gattc_if, conn_id, handle, value_len, value);
+}
+
+esp_err_t esp_ble_gap_stop_scanning() { return ESP_OK; }
+
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t *params) { return ESP_OK; }
+
+size_t heap_caps_get_free_size(uint32_t caps) { return 0; }
+size_t heap_caps_get_minimum_free_size(uint32_t caps) { return 0; }
+size_t heap_caps_get_largest_free_block(uint32_t caps) { return 0; }
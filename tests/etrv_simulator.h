@@ -0,0 +1,197 @@
+#pragma once
+
+#include "esphome/components/ble_client/ble_client.h"
+#include "esphome/components/esp32_ble_tracker/esp32_ble_tracker.h"
+#include "esphome/core/application.h"
+
+#include "device.h"
+#include "scheduler.h"
+
+#include <esp_gattc_api.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+// Host stand-in for the Bluedroid GATT client and a number of Danfoss Eco eTRVs. The esp_ble_gattc_* calls of ble_client
+// and of the component are answered by the simulated eTRVs, the responses are delivered as GATT events on a virtual clock,
+// so an hour of polling runs in a fraction of a second. Faults are injected per request.
+namespace sim
+{
+    // characteristic handles of the eTRV firmware, as noted in schema.h
+    const uint16_t HANDLE_BATTERY = 0x10;
+    const uint16_t HANDLE_PIN = 0x24;
+    const uint16_t HANDLE_SETTINGS = 0x2a;
+    const uint16_t HANDLE_TEMPERATURE = 0x2d;
+    const uint16_t HANDLE_ERRORS = 0x39;
+    const uint16_t HANDLE_SECRET_KEY = 0x3f;
+
+    // Latencies and fault rates, the rates are probabilities per connection attempt or per request.
+    // A dropped response simply never arrives, the bearer is not blocked until the ATT timeout like on a real link
+    struct Faults
+    {
+        uint32_t latency = 30;            // ms, ATT request to response
+        uint32_t jitter = 30;             // ms, added uniformly to every latency
+        uint32_t connect_latency = 300;   // ms, esp_ble_gattc_open to ESP_GATTC_OPEN_EVT
+        uint32_t discovery_latency = 400; // ms, esp_ble_gattc_search_service to ESP_GATTC_SEARCH_CMPL_EVT
+        uint32_t connect_timeout = 30000; // ms, an eTRV out of range fails to open after this
+        float connect_failure_rate = 0;   // ESP_GATTC_OPEN_EVT fails with ESP_GATT_ERROR
+        float drop_rate = 0;              // the response never arrives
+        float error_rate = 0;             // the request fails with error_status
+        esp_gatt_status_t error_status = ESP_GATT_ERROR;
+        float link_loss_rate = 0; // the eTRV drops the link instead of responding
+    };
+
+    // injected faults and the traffic, since the simulator was created
+    struct Stats
+    {
+        uint32_t opens = 0;
+        uint32_t open_failures = 0;
+        uint32_t requests = 0;
+        uint32_t read_multiple = 0;
+        uint32_t dropped = 0;
+        uint32_t errors = 0;
+        uint32_t link_losses = 0;
+    };
+
+    // GATT server of a single eTRV. Values are stored plain and encrypted with the reference XXTEA on every read
+    class Etrv
+    {
+    public:
+        Etrv(uint64_t address, std::mt19937 &rng);
+
+        esp_gatt_status_t read(uint16_t handle, bool authorized, std::vector<uint8_t> &value);
+        // a write of the correct PIN authorizes the link
+        esp_gatt_status_t write(uint16_t handle, const uint8_t *value, uint16_t value_len, bool &authorized);
+
+        std::string secret_key() const;
+
+        uint64_t address;
+        uint32_t pin_code = 0;
+        uint8_t key[16];
+        bool present = true;        // in range
+        bool button_pressed = false; // the secret key characteristic is exposed
+        bool read_multiple = true;   // the firmware supports read-multiple
+        uint16_t mtu = 23;
+
+        uint8_t battery = 85;
+        float room_temperature = 20.5;
+        float target_temperature = 21;
+        uint8_t settings[16];
+        uint8_t errors[8] = {0};
+
+        uint32_t last_open = 0; // millis of the last connection attempt
+        uint32_t reads = 0;
+        uint32_t writes = 0;
+    };
+
+    class Simulator
+    {
+    public:
+        explicit Simulator(uint32_t seed = 1);
+        ~Simulator();
+
+        // the simulator, which answers the esp_ble_gattc_* calls
+        static Simulator *instance() { return current_; }
+
+        Etrv &add_etrv(uint64_t address);
+        Etrv *find_etrv(const uint8_t *bda);
+
+        // runs the GATT events and App.loop() every loop_interval, until the virtual clock reaches the time
+        void run_until(uint32_t time);
+        void run_for(uint32_t duration) { this->run_until(esphome::App.get_time() + duration); }
+
+        // App.setup() and ESP_GATTC_REG_EVT of the registered clients
+        void setup();
+
+        esp_err_t app_register(uint16_t app_id);
+        esp_err_t open(esp_gatt_if_t gattc_if, const uint8_t *bda);
+        esp_err_t close(esp_gatt_if_t gattc_if, uint16_t conn_id);
+        esp_err_t send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id);
+        esp_err_t search_service(esp_gatt_if_t gattc_if, uint16_t conn_id);
+        esp_gatt_status_t get_service(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_gattc_service_elem_t *result, uint16_t *count, uint16_t offset);
+        esp_gatt_status_t get_all_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t start_handle, uint16_t end_handle,
+                                       esp_gattc_char_elem_t *result, uint16_t *count, uint16_t offset);
+        esp_err_t read_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle);
+        esp_err_t read_multiple(esp_gatt_if_t gattc_if, uint16_t conn_id, const esp_gattc_multi_t *read_multi);
+        esp_err_t write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t value_len, const uint8_t *value);
+
+        Faults faults;
+        Stats stats;
+        uint32_t loop_interval = 16; // ms, ESPHome runs the main loop every 16 ms
+
+    protected:
+        enum class LinkState
+        {
+            IDLE,
+            OPENING,
+            OPEN,
+            CLOSING
+        };
+
+        // connection of a registered GATT client
+        struct Link
+        {
+            LinkState state = LinkState::IDLE;
+            Etrv *etrv = nullptr;
+            uint16_t conn_id = 0;
+            uint32_t generation = 0; // events of a previous connection are not delivered
+            bool authorized = false;
+            uint16_t mtu = ESP_GATT_DEF_BLE_MTU_SIZE;
+            uint32_t busy_until = 0; // ATT serves a single request at a time, the following ones wait in the stack
+        };
+
+        struct Event
+        {
+            uint32_t at;
+            uint64_t seq;
+            esp_gatt_if_t gattc_if;
+            uint32_t generation;
+            std::function<void()> deliver;
+
+            bool operator>(const Event &other) const { return this->at != other.at ? this->at > other.at : this->seq > other.seq; }
+        };
+
+        Link *find_link(esp_gatt_if_t gattc_if, uint16_t conn_id);
+        void schedule(uint32_t at, esp_gatt_if_t gattc_if, std::function<void()> deliver);
+        void dispatch(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t &param);
+        // CONNECT and DISCONNECT are delivered to every registered client, like Bluedroid does
+        void broadcast(esp_gattc_cb_event_t event, esp_ble_gattc_cb_param_t &param);
+        void close_link(esp_gatt_if_t gattc_if, esp_gatt_conn_reason_t reason);
+        // the time of the response, or false if the request should not be answered
+        bool request(esp_gatt_if_t gattc_if, uint32_t &at, esp_gatt_status_t &status);
+        uint32_t delay(uint32_t latency);
+        bool chance(float rate) { return rate > 0 && this->uniform_(this->rng_) < rate; }
+
+        static Simulator *current_;
+
+        std::mt19937 rng_;
+        std::uniform_real_distribution<float> uniform_{0.0f, 1.0f};
+        std::vector<std::unique_ptr<Etrv>> etrvs_;
+        std::map<esp_gatt_if_t, Link> links_;
+        std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+        uint64_t seq_ = 0;
+        uint16_t next_conn_id_ = 0;
+        esp_gatt_if_t next_gattc_if_ = 3;
+        uint32_t next_loop_ = 0;
+    };
+
+    // Components of an ESPHome node with pooled devices, created and configured like the code generated by climate.py.
+    // Like on the device, the components are never freed
+    struct Node
+    {
+        explicit Node(size_t clients, uint8_t max_connections = 1);
+
+        esphome::danfoss_eco::Device *add_device(const Etrv &etrv, const std::string &name, bool with_key = true);
+
+        esphome::esp32_ble_tracker::ESP32BLETracker *tracker;
+        esphome::danfoss_eco::ConnectionScheduler *scheduler;
+        std::vector<esphome::ble_client::BLEClient *> clients;
+        std::vector<esphome::danfoss_eco::Device *> devices;
+    };
+} // namespace sim
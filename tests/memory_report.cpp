@@ -0,0 +1,111 @@
+#include "etrv_simulator.h"
+#include "test.h"
+
+#include "device_data.h"
+#include "xxtea.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Sizes of the component data structures and the heap allocations of a device, as built for the host.
+// The sizes on ESP32 (32-bit pointers) are smaller, run it to spot a regression in the footprint:
+//
+//   build/memory_report
+
+using namespace esphome;
+using namespace esphome::danfoss_eco;
+
+// allocations are only counted while `counting` is set
+static bool counting = false;
+static size_t allocations = 0;
+static size_t allocated = 0;
+
+void *operator new(size_t size)
+{
+    if (counting)
+    {
+        allocations++;
+        allocated += size;
+    }
+    void *p = malloc(size > 0 ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+#define PRINT_SIZE(type) printf("  %-28s %5zu\n", #type, sizeof(type))
+
+struct Allocations
+{
+    size_t count;
+    size_t bytes;
+};
+
+// allocations of a node with the given number of pooled devices, from their creation to the end of App.setup()
+static Allocations setup_allocations(size_t devices, MemoryUsage &usage)
+{
+    sim::Simulator sim;
+    sim::Node node(1);
+    std::vector<sim::Etrv *> etrvs;
+    for (size_t i = 0; i < devices; i++)
+        etrvs.push_back(&sim.add_etrv(0x00046f000000 + i));
+
+    allocations = 0;
+    allocated = 0;
+    counting = true;
+    for (size_t i = 0; i < devices; i++)
+        node.add_device(*etrvs[i], "etrv_" + std::to_string(i));
+    sim.setup();
+    counting = false;
+
+    usage = node.devices.front()->memory_usage();
+    return {allocations, allocated};
+}
+
+int main()
+{
+    printf("sizeof, bytes:\n");
+    PRINT_SIZE(Device);
+    PRINT_SIZE(RequestPipeline);
+    PRINT_SIZE(Command);
+    PRINT_SIZE(GattEvent);
+    PRINT_SIZE(XxteaKey);
+    PRINT_SIZE(DeviceProperty);
+    PRINT_SIZE(WritableProperty);
+    PRINT_SIZE(BatteryProperty);
+    PRINT_SIZE(TemperatureProperty);
+    PRINT_SIZE(SettingsProperty);
+    PRINT_SIZE(ErrorsProperty);
+    PRINT_SIZE(SecretKeyProperty);
+    PRINT_SIZE(TemperatureData);
+    PRINT_SIZE(SettingsData);
+    PRINT_SIZE(ErrorsData);
+
+    MemoryUsage usage;
+    Allocations one = setup_allocations(1, usage);
+    Allocations many = setup_allocations(9, usage);
+
+    printf("memory_usage(), bytes:\n");
+    printf("  device %zu, request pipeline %zu (command queue %zu, in flight %zu), GATT event queue %zu, key %zu\n",
+           usage.device, usage.pipeline, usage.command_queue, usage.in_flight, usage.gatt_events, usage.key);
+    printf("  properties %zu (decoded data %zu), shared_ptr control blocks %zu, total %zu\n",
+           usage.properties, usage.data, usage.control_blocks, usage.total());
+
+    // vectors of the node grow with the devices, the difference is averaged over the added devices
+    size_t count = (many.count - one.count) / 8;
+    size_t bytes = (many.bytes - one.bytes) / 8;
+    printf("heap allocations per device: %zu, %zu bytes (memory_usage() covers %zu)\n", count, bytes, usage.total());
+
+    CHECK(usage.command_queue > 0 && usage.in_flight > 0);
+    CHECK(usage.command_queue + usage.in_flight < usage.pipeline);
+    // the device control block and a block for every property, each holding the counts
+    CHECK(usage.control_blocks >= (PROPERTY_COUNT + 1) * 2 * sizeof(int));
+    // the device, its properties and the control blocks are allocated, the name and the preferences on top of them
+    CHECK(bytes >= usage.total());
+    return test_result("memory_report");
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// The previous encryption path: the generic XXTEA of xxtea-iot-crypt (dtea_fn1) on a scratch copy of the value,
+// with the byte order of every 32 bit word reversed before and after it. Used as the reference for XxteaBlock.
+namespace reference
+{
+    const uint32_t DELTA = 0x9e3779b9;
+
+    inline uint32_t mx(uint32_t sum, uint32_t y, uint32_t z, unsigned p, unsigned e, const uint32_t *k)
+    {
+        return (((z >> 5) ^ (y << 2)) + ((y >> 3) ^ (z << 4))) ^ ((sum ^ y) + (k[(p & 3) ^ e] ^ z));
+    }
+
+    // n > 1 encrypts, n < -1 decrypts n words
+    inline void dtea_fn1(uint32_t *v, int32_t n, const uint32_t *k)
+    {
+        uint32_t y, z, sum;
+        unsigned p, rounds, e;
+        if (n > 1)
+        {
+            rounds = 6 + 52 / n;
+            sum = 0;
+            z = v[n - 1];
+            do
+            {
+                sum += DELTA;
+                e = (sum >> 2) & 3;
+                for (p = 0; p < (unsigned)n - 1; p++)
+                {
+                    y = v[p + 1];
+                    z = v[p] += mx(sum, y, z, p, e, k);
+                }
+                y = v[0];
+                z = v[n - 1] += mx(sum, y, z, p, e, k);
+            } while (--rounds);
+        }
+        else if (n < -1)
+        {
+            n = -n;
+            rounds = 6 + 52 / n;
+            sum = rounds * DELTA;
+            y = v[0];
+            do
+            {
+                e = (sum >> 2) & 3;
+                for (p = n - 1; p > 0; p--)
+                {
+                    z = v[p - 1];
+                    y = v[p] -= mx(sum, y, z, p, e, k);
+                }
+                z = v[n - 1];
+                y = v[0] -= mx(sum, y, z, p, e, k);
+            } while ((sum -= DELTA) != 0);
+        }
+    }
+
+    template <size_t Len>
+    void reverse_chunks(const uint8_t *data, uint8_t *reversed)
+    {
+        for (size_t i = 0; i < Len; i += 4)
+            for (size_t j = 0; j < 4; j++)
+                reversed[i + j] = data[i + 3 - j];
+    }
+
+    // key words are little-endian, data words big-endian
+    template <size_t Len>
+    void crypt(const uint32_t *k, uint8_t *value, bool encrypt)
+    {
+        uint8_t buff[Len];
+        uint32_t words[Len / 4];
+        reverse_chunks<Len>(value, buff);
+        memcpy(words, buff, Len);
+        dtea_fn1(words, encrypt ? (int32_t)(Len / 4) : -(int32_t)(Len / 4), k);
+        memcpy(buff, words, Len);
+        reverse_chunks<Len>(buff, value);
+    }
+
+    inline void crypt(const uint8_t *key, uint8_t *value, size_t len, bool encrypt)
+    {
+        uint32_t k[4];
+        for (size_t i = 0; i < 4; i++)
+            k[i] = key[i * 4] | key[i * 4 + 1] << 8 | key[i * 4 + 2] << 16 | (uint32_t)key[i * 4 + 3] << 24;
+
+        if (len == 8)
+            crypt<8>(k, value, encrypt);
+        else if (len == 16)
+            crypt<16>(k, value, encrypt);
+    }
+} // namespace reference
@@ -0,0 +1,229 @@
+#include "etrv_simulator.h"
+#include "test.h"
+
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/preferences.h"
+
+#include <cmath>
+
+// Sessions of the component against the simulated eTRVs: discovery, PIN, polling, writes and the injected faults
+
+using namespace esphome;
+using danfoss_eco::Device;
+
+static const uint64_t ADDRESS = 0x00046f112233;
+
+struct Counter
+{
+    explicit Counter(Device *device)
+    {
+        device->add_on_state_callback([this](climate::Climate &)
+                                      { this->publishes++; });
+    }
+
+    int publishes = 0;
+};
+
+static sensor::Sensor *failures_sensor(Device *device)
+{
+    auto *sensor = new sensor::Sensor();
+    device->set_session_failures(sensor);
+    return sensor;
+}
+
+static void test_poll()
+{
+    sim::Simulator sim;
+    auto &etrv = sim.add_etrv(ADDRESS);
+    etrv.room_temperature = 19.5;
+    etrv.pin_code = 1234;
+
+    sim::Node node(1);
+    auto *device = node.add_device(etrv, "poll");
+    Counter counter(device);
+    sim.setup();
+
+    // the first session discovers the services, writes the PIN and reads the whole state
+    sim.run_for(10000);
+    CHECK(counter.publishes == 1);
+    CHECK(device->current_temperature == 19.5f);
+    CHECK(device->target_temperature == 21.0f);
+    CHECK(device->mode == climate::CLIMATE_MODE_HEAT);
+    CHECK(device->action == climate::CLIMATE_ACTION_HEATING);
+    CHECK(!global_preferences->values.empty()); // the handles were cached
+    CHECK(sim.stats.opens == 1);
+
+    // the next poll reads the changed temperature and publishes it
+    etrv.room_temperature = 22.0;
+    sim.run_until(70000);
+    CHECK(counter.publishes == 2);
+    CHECK(device->current_temperature == 22.0f);
+    CHECK(device->action == climate::CLIMATE_ACTION_IDLE);
+    CHECK(sim.stats.opens == 2);
+}
+
+static void test_secret_key()
+{
+    sim::Simulator sim;
+    auto &etrv = sim.add_etrv(ADDRESS);
+    etrv.button_pressed = true;
+
+    sim::Node node(1);
+    auto *device = node.add_device(etrv, "secret_key", false);
+    sim.setup();
+
+    // the key is read and saved by the first session, the state is only read by the next poll
+    sim.run_for(10000);
+    size_t saved = global_preferences->values.size();
+    CHECK(saved == 2); // the handles and the key
+
+    etrv.button_pressed = false;
+    sim.run_until(70000);
+    CHECK(device->current_temperature == etrv.room_temperature);
+    CHECK(device->target_temperature == etrv.target_temperature);
+}
+
+static void test_wrong_pin()
+{
+    sim::Simulator sim;
+    auto &etrv = sim.add_etrv(ADDRESS);
+
+    sim::Node node(1);
+    auto *device = node.add_device(etrv, "wrong_pin");
+    Counter counter(device);
+    auto *failures = failures_sensor(device);
+    etrv.pin_code = 4321;
+    sim.setup();
+
+    // a rejected PIN fails the component, it would only keep on draining the eTRV battery
+    sim.run_for(70000);
+    CHECK(device->is_failed());
+    CHECK(counter.publishes == 0);
+    CHECK(failures->state == 1);
+    CHECK(sim.stats.opens == 1);
+}
+
+static void test_dropped_responses()
+{
+    sim::Simulator sim(7);
+    sim.faults.drop_rate = 0.2;
+    auto &etrv = sim.add_etrv(ADDRESS);
+
+    sim::Node node(1);
+    auto *device = node.add_device(etrv, "dropped");
+    device->set_max_silence(0);
+    Counter counter(device);
+    sim.setup();
+
+    // timed out requests are retried, most of the polls still succeed
+    sim.run_until(10 * 60000 - 1000);
+    CHECK(sim.stats.dropped > 0);
+    CHECK(counter.publishes >= 8);
+}
+
+static void test_read_multiple_unsupported()
+{
+    sim::Simulator sim;
+    auto &etrv = sim.add_etrv(ADDRESS);
+    etrv.read_multiple = false;
+
+    sim::Node node(1);
+    auto *device = node.add_device(etrv, "read_multiple");
+    Counter counter(device);
+    auto *failures = failures_sensor(device);
+    sim.setup();
+
+    // the batches of the first poll fall back to single reads, the following polls do not try read-multiple again
+    sim.run_for(10000);
+    uint32_t read_multiple = sim.stats.read_multiple;
+    CHECK(read_multiple > 0);
+    CHECK(counter.publishes == 1);
+    CHECK(device->current_temperature == etrv.room_temperature);
+
+    etrv.room_temperature = 18;
+    sim.run_until(2 * 60000 + 10000);
+    CHECK(sim.stats.read_multiple == read_multiple);
+    CHECK(device->current_temperature == 18.0f);
+    CHECK(!failures->has_state());
+}
+
+static void test_link_loss()
+{
+    sim::Simulator sim;
+    auto &etrv = sim.add_etrv(ADDRESS);
+
+    sim::Node node(1);
+    auto *device = node.add_device(etrv, "link_loss");
+    Counter counter(device);
+    auto *failures = failures_sensor(device);
+    sim.setup();
+
+    // the lost link ends the session right away, instead of waiting for the session timeout
+    sim.faults.link_loss_rate = 1;
+    sim.run_for(10000);
+    CHECK(sim.stats.link_losses == 1);
+    CHECK(failures->state == 1);
+    CHECK(counter.publishes == 0);
+
+    sim.faults.link_loss_rate = 0;
+    sim.run_until(70000);
+    CHECK(counter.publishes == 1);
+    CHECK(failures->state == 1);
+}
+
+static void test_control()
+{
+    sim::Simulator sim;
+    auto &etrv = sim.add_etrv(ADDRESS);
+
+    sim::Node node(1);
+    auto *device = node.add_device(etrv, "control");
+    sim.setup();
+    sim.run_for(10000);
+    CHECK(device->target_temperature == 21.0f);
+
+    // the change is written after the debounce window by an urgent session, and read back
+    device->make_call().set_target_temperature(23.5).perform();
+    sim.run_for(10000);
+    CHECK(etrv.target_temperature == 23.5f);
+    CHECK(device->target_temperature == 23.5f);
+    CHECK(sim.stats.opens == 2);
+}
+
+static void test_pool()
+{
+    sim::Simulator sim;
+    sim::Node node(2, 2);
+
+    // the counters are captured by the callbacks, they should not move
+    std::vector<Counter> counters;
+    counters.reserve(6);
+    for (int i = 0; i < 6; i++)
+    {
+        auto &etrv = sim.add_etrv(ADDRESS + i);
+        etrv.room_temperature = 18 + i;
+        counters.emplace_back(node.add_device(etrv, "pool_" + std::to_string(i)));
+    }
+    sim.setup();
+
+    // the polls are spread across the update interval, every device gets a client of the pool
+    sim.run_for(60000);
+    for (int i = 0; i < 6; i++)
+    {
+        CHECK(counters[i].publishes == 1);
+        CHECK(node.devices[i]->current_temperature == 18.0f + i);
+    }
+}
+
+int main()
+{
+    test_poll();
+    test_secret_key();
+    test_wrong_pin();
+    test_dropped_responses();
+    test_read_multiple_unsupported();
+    test_link_loss();
+    test_control();
+    test_pool();
+    return test_result("simulator_test");
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "esp_bt_defs.h"
+#include "esp_err.h"
+
+typedef struct
+{
+    esp_bd_addr_t bda;
+    uint16_t min_int;
+    uint16_t max_int;
+    uint16_t latency;
+    uint16_t timeout;
+} esp_ble_conn_update_params_t;
+
+esp_err_t esp_ble_gap_stop_scanning();
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t *params);
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "esp_bt_defs.h"
+
+#include <cstdint>
+
+// the subset of the ESP-IDF GATT definitions used by ble_client and the component, with the ESP-IDF values
+
+typedef enum
+{
+    ESP_GATT_OK = 0x00,
+    ESP_GATT_INVALID_HANDLE = 0x01,
+    ESP_GATT_READ_NOT_PERMIT = 0x02,
+    ESP_GATT_WRITE_NOT_PERMIT = 0x03,
+    ESP_GATT_INVALID_PDU = 0x04,
+    ESP_GATT_INSUF_AUTHENTICATION = 0x05,
+    ESP_GATT_REQ_NOT_SUPPORTED = 0x06,
+    ESP_GATT_INVALID_OFFSET = 0x07,
+    ESP_GATT_INSUF_AUTHORIZATION = 0x08,
+    ESP_GATT_NOT_FOUND = 0x0a,
+    ESP_GATT_INVALID_ATTR_LEN = 0x0d,
+    ESP_GATT_INSUF_RESOURCE = 0x11,
+    ESP_GATT_NO_RESOURCES = 0x80,
+    ESP_GATT_INTERNAL_ERROR = 0x81,
+    ESP_GATT_WRONG_STATE = 0x82,
+    ESP_GATT_BUSY = 0x84,
+    ESP_GATT_ERROR = 0x85,
+    ESP_GATT_ILLEGAL_PARAMETER = 0x87,
+    ESP_GATT_CONGESTED = 0x8f,
+    ESP_GATT_ALREADY_OPEN = 0x91,
+    ESP_GATT_CANCEL = 0x92,
+    ESP_GATT_STACK_RSP = 0xe0,
+    ESP_GATT_APP_RSP = 0xe1,
+    ESP_GATT_UNKNOWN_ERROR = 0xef,
+    ESP_GATT_CCC_CFG_ERR = 0xfd,
+    ESP_GATT_PRC_IN_PROGRESS = 0xfe,
+    ESP_GATT_OUT_OF_RANGE = 0xff
+} esp_gatt_status_t;
+
+typedef enum
+{
+    ESP_GATT_CONN_UNKNOWN = 0,
+    ESP_GATT_CONN_L2C_FAILURE = 1,
+    ESP_GATT_CONN_TIMEOUT = 0x08,
+    ESP_GATT_CONN_TERMINATE_PEER_USER = 0x13,
+    ESP_GATT_CONN_TERMINATE_LOCAL_HOST = 0x16,
+    ESP_GATT_CONN_FAIL_ESTABLISH = 0x3e,
+    ESP_GATT_CONN_LMP_TIMEOUT = 0x22,
+    ESP_GATT_CONN_CONN_CANCEL = 0x0100,
+    ESP_GATT_CONN_NONE = 0x0101
+} esp_gatt_conn_reason_t;
+
+typedef enum
+{
+    ESP_GATT_AUTH_REQ_NONE = 0,
+    ESP_GATT_AUTH_REQ_NO_MITM = 1,
+    ESP_GATT_AUTH_REQ_MITM = 2
+} esp_gatt_auth_req_t;
+
+typedef enum
+{
+    ESP_GATT_WRITE_TYPE_NO_RSP = 1,
+    ESP_GATT_WRITE_TYPE_RSP
+} esp_gatt_write_type_t;
+
+typedef uint8_t esp_gatt_if_t;
+typedef uint8_t esp_gatt_char_prop_t;
+
+#define ESP_GATT_IF_NONE 0xff
+#define ESP_GATT_DEF_BLE_MTU_SIZE 23
+#define ESP_GATT_MAX_MTU_SIZE 517
+#define ESP_GATT_MAX_READ_MULTI_HANDLES 10
+
+#define ESP_GATT_CHAR_PROP_BIT_READ (1 << 1)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE (1 << 3)
+
+typedef struct
+{
+    uint8_t num_attr;
+    uint16_t handles[ESP_GATT_MAX_READ_MULTI_HANDLES];
+} esp_gattc_multi_t;
+
+typedef struct
+{
+    bool is_primary;
+    uint16_t start_handle;
+    uint16_t end_handle;
+    esp_bt_uuid_t uuid;
+} esp_gattc_service_elem_t;
+
+typedef struct
+{
+    uint16_t char_handle;
+    esp_gatt_char_prop_t properties;
+    esp_bt_uuid_t uuid;
+} esp_gattc_char_elem_t;
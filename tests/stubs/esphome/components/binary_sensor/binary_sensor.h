@@ -0,0 +1,36 @@
+#pragma once
+
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+#define LOG_BINARY_SENSOR(prefix, type, obj)                                       \
+    if ((obj) != nullptr)                                                          \
+    {                                                                              \
+        ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name().c_str()); \
+    }
+
+namespace esphome
+{
+    namespace binary_sensor
+    {
+        class BinarySensor : public EntityBase
+        {
+        public:
+            void publish_state(bool state)
+            {
+                this->state = state;
+                this->has_state_ = true;
+                this->callback_.call(state);
+            }
+            void add_on_state_callback(std::function<void(bool)> &&callback) { this->callback_.add(std::move(callback)); }
+            bool has_state() const { return this->has_state_; }
+
+            bool state{false};
+
+        protected:
+            bool has_state_ = false;
+            CallbackManager<void(bool)> callback_;
+        };
+    } // namespace binary_sensor
+} // namespace esphome
@@ -0,0 +1,244 @@
+#include "ble_client.h"
+
+#include "esphome/core/log.h"
+
+#include <cstring>
+
+namespace esphome
+{
+    namespace ble_client
+    {
+        static const char *const TAG = "ble_client";
+
+        BLECharacteristic *BLEService::get_characteristic(espbt::ESPBTUUID uuid)
+        {
+            for (auto &chr : this->characteristics)
+                if (chr->uuid == uuid)
+                    return chr.get();
+            return nullptr;
+        }
+
+        void BLEService::parse_characteristics()
+        {
+            uint16_t offset = 0;
+            esp_gattc_char_elem_t result;
+            for (;;)
+            {
+                uint16_t count = 1;
+                auto status = esp_ble_gattc_get_all_char(this->client->get_gattc_if(), this->client->get_conn_id(),
+                                                         this->start_handle, this->end_handle, &result, &count, offset);
+                if (status == ESP_GATT_INVALID_OFFSET || status == ESP_GATT_NOT_FOUND || count == 0)
+                    break;
+                if (status != ESP_GATT_OK)
+                {
+                    ESP_LOGW(TAG, "esp_ble_gattc_get_all_char error, status=%d", status);
+                    break;
+                }
+
+                auto chr = std::unique_ptr<BLECharacteristic>(new BLECharacteristic());
+                chr->uuid = espbt::ESPBTUUID::from_uuid(result.uuid);
+                chr->handle = result.char_handle;
+                chr->properties = result.properties;
+                this->characteristics.push_back(std::move(chr));
+                offset++;
+            }
+        }
+
+        void BLEClient::setup()
+        {
+            espbt::global_esp32_ble_tracker->register_client(this);
+            auto ret = esp_ble_gattc_app_register(this->app_id);
+            if (ret != ESP_OK)
+            {
+                ESP_LOGE(TAG, "gattc app register failed. app_id=%d code=%d", this->app_id, ret);
+                this->mark_failed();
+            }
+            this->set_state(espbt::ClientState::IDLE);
+            this->enabled = true;
+        }
+
+        void BLEClient::loop()
+        {
+            if (this->state() == espbt::ClientState::READY_TO_CONNECT && this->enabled)
+                this->connect();
+
+            for (auto *node : this->nodes_)
+                node->loop();
+        }
+
+        void BLEClient::set_state(espbt::ClientState state)
+        {
+            ESPBTClient::set_state(state);
+            for (auto *node : this->nodes_)
+                node->node_state = state;
+        }
+
+        void BLEClient::set_enabled(bool enabled)
+        {
+            if (enabled == this->enabled)
+                return;
+            if (!enabled && this->state() != espbt::ClientState::IDLE)
+            {
+                ESP_LOGI(TAG, "[%s] Disabling BLE client.", this->address_str().c_str());
+                auto ret = esp_ble_gattc_close(this->gattc_if_, this->conn_id_);
+                if (ret)
+                    ESP_LOGW(TAG, "esp_ble_gattc_close error, address=%s status=%d", this->address_str().c_str(), ret);
+            }
+            this->enabled = enabled;
+        }
+
+        void BLEClient::connect()
+        {
+            ESP_LOGI(TAG, "Attempting BLE connection to %s", this->address_str().c_str());
+            auto ret = esp_ble_gattc_open(this->gattc_if_, this->remote_bda_, BLE_ADDR_TYPE_PUBLIC, true);
+            if (ret)
+            {
+                ESP_LOGW(TAG, "esp_ble_gattc_open error, address=%s status=%d", this->address_str().c_str(), ret);
+                this->set_state(espbt::ClientState::IDLE);
+            }
+            else
+                this->set_state(espbt::ClientState::CONNECTING);
+        }
+
+        bool BLEClient::gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t esp_gattc_if, esp_ble_gattc_cb_param_t *param)
+        {
+            if (event == ESP_GATTC_REG_EVT && this->app_id != param->reg.app_id)
+                return false;
+            if (event != ESP_GATTC_REG_EVT && esp_gattc_if != ESP_GATT_IF_NONE && esp_gattc_if != this->gattc_if_)
+                return false;
+
+            bool all_established = this->all_nodes_established_();
+
+            switch (event)
+            {
+            case ESP_GATTC_REG_EVT:
+                if (param->reg.status == ESP_GATT_OK)
+                    this->gattc_if_ = esp_gattc_if;
+                else
+                {
+                    ESP_LOGE(TAG, "gattc app registration failed id=%d code=%d", param->reg.app_id, param->reg.status);
+                    return false;
+                }
+                break;
+
+            case ESP_GATTC_OPEN_EVT:
+                this->conn_id_ = param->open.conn_id;
+                if (param->open.status != ESP_GATT_OK && param->open.status != ESP_GATT_ALREADY_OPEN)
+                {
+                    ESP_LOGW(TAG, "connect to %s failed, status=%d", this->address_str().c_str(), param->open.status);
+                    this->set_state(espbt::ClientState::IDLE);
+                }
+                break;
+
+            case ESP_GATTC_CONNECT_EVT:
+            {
+                if (memcmp(param->connect.remote_bda, this->remote_bda_, ESP_BD_ADDR_LEN) != 0)
+                    return false;
+                auto ret = esp_ble_gattc_send_mtu_req(this->gattc_if_, param->connect.conn_id);
+                if (ret)
+                    ESP_LOGW(TAG, "esp_ble_gattc_send_mtu_req failed, status=%x", ret);
+                break;
+            }
+
+            case ESP_GATTC_CFG_MTU_EVT:
+                if (param->cfg_mtu.status != ESP_GATT_OK)
+                    ESP_LOGW(TAG, "cfg_mtu to %s failed, mtu %d, status %d", this->address_str().c_str(), param->cfg_mtu.mtu, param->cfg_mtu.status);
+                esp_ble_gattc_search_service(esp_gattc_if, param->cfg_mtu.conn_id, nullptr);
+                break;
+
+            case ESP_GATTC_DISCONNECT_EVT:
+                if (memcmp(param->disconnect.remote_bda, this->remote_bda_, ESP_BD_ADDR_LEN) != 0)
+                    return false;
+                ESP_LOGV(TAG, "[%s] ESP_GATTC_DISCONNECT_EVT, reason %d", this->address_str().c_str(), param->disconnect.reason);
+                this->services_.clear();
+                this->set_state(espbt::ClientState::IDLE);
+                break;
+
+            case ESP_GATTC_SEARCH_CMPL_EVT:
+                // ESP-IDF reports every service with ESP_GATTC_SEARCH_RES_EVT, the simulator lets them be read back from its cache
+                this->discover_services_();
+                ESP_LOGI(TAG, "Connected to %s", this->address_str().c_str());
+                this->set_state(espbt::ClientState::CONNECTED);
+                this->state_ = espbt::ClientState::ESTABLISHED;
+                break;
+
+            default:
+                break;
+            }
+
+            for (auto *node : this->nodes_)
+                node->gattc_event_handler(event, esp_gattc_if, param);
+
+            // the services are only needed until the nodes have resolved their handles
+            if (!all_established && this->all_nodes_established_())
+                this->services_.clear();
+            return true;
+        }
+
+        bool BLEClient::all_nodes_established_()
+        {
+            if (this->state() != espbt::ClientState::ESTABLISHED)
+                return false;
+            for (auto *node : this->nodes_)
+                if (node->node_state != espbt::ClientState::ESTABLISHED)
+                    return false;
+            return true;
+        }
+
+        void BLEClient::discover_services_()
+        {
+            this->services_.clear();
+
+            uint16_t offset = 0;
+            esp_gattc_service_elem_t result;
+            for (;;)
+            {
+                uint16_t count = 1;
+                auto status = esp_ble_gattc_get_service(this->gattc_if_, this->conn_id_, nullptr, &result, &count, offset);
+                if (status != ESP_GATT_OK || count == 0)
+                    break;
+
+                auto service = std::unique_ptr<BLEService>(new BLEService());
+                service->uuid = espbt::ESPBTUUID::from_uuid(result.uuid);
+                service->start_handle = result.start_handle;
+                service->end_handle = result.end_handle;
+                service->client = this;
+                service->parse_characteristics();
+                this->services_.push_back(std::move(service));
+                offset++;
+            }
+        }
+
+        BLEService *BLEClient::get_service(espbt::ESPBTUUID uuid)
+        {
+            for (auto &service : this->services_)
+                if (service->uuid == uuid)
+                    return service.get();
+            return nullptr;
+        }
+
+        BLECharacteristic *BLEClient::get_characteristic(espbt::ESPBTUUID service, espbt::ESPBTUUID chr)
+        {
+            auto *svc = this->get_service(service);
+            if (svc == nullptr)
+                return nullptr;
+            return svc->get_characteristic(chr);
+        }
+
+        void BLEClient::set_address(uint64_t address)
+        {
+            this->address_ = address;
+            for (int i = 0; i < ESP_BD_ADDR_LEN; i++)
+                this->remote_bda_[i] = address >> (8 * (ESP_BD_ADDR_LEN - 1 - i));
+        }
+
+        std::string BLEClient::address_str() const
+        {
+            char buff[18];
+            snprintf(buff, sizeof(buff), "%02X:%02X:%02X:%02X:%02X:%02X",
+                     (uint8_t)(this->address_ >> 40), (uint8_t)(this->address_ >> 32), (uint8_t)(this->address_ >> 24),
+                     (uint8_t)(this->address_ >> 16), (uint8_t)(this->address_ >> 8), (uint8_t)(this->address_ >> 0));
+            return buff;
+        }
+    } // namespace ble_client
+} // namespace esphome
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "esphome/components/esp32_ble_tracker/esp32_ble_tracker.h"
+#include "esphome/core/component.h"
+
+#include <esp_gattc_api.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace esphome
+{
+    namespace ble_client
+    {
+        namespace espbt = esphome::esp32_ble_tracker;
+
+        class BLEClient;
+
+        class BLECharacteristic
+        {
+        public:
+            espbt::ESPBTUUID uuid;
+            uint16_t handle;
+            esp_gatt_char_prop_t properties;
+        };
+
+        class BLEService
+        {
+        public:
+            BLECharacteristic *get_characteristic(espbt::ESPBTUUID uuid);
+            void parse_characteristics();
+
+            espbt::ESPBTUUID uuid;
+            uint16_t start_handle;
+            uint16_t end_handle;
+            std::vector<std::unique_ptr<BLECharacteristic>> characteristics;
+            BLEClient *client;
+        };
+
+        class BLEClientNode
+        {
+        public:
+            virtual void gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param) = 0;
+            virtual void loop() {}
+
+            BLEClient *parent() { return this->parent_; }
+            void set_ble_client_parent(BLEClient *parent) { this->parent_ = parent; }
+
+            // the discovered services are released, once all nodes are ESTABLISHED
+            espbt::ClientState node_state = espbt::ClientState::INIT;
+
+        protected:
+            BLEClient *parent_{nullptr};
+        };
+
+        // The connection state machine of ESPHome 2022 ble_client, driven by the esp_ble_gattc_* calls of the simulator
+        class BLEClient : public espbt::ESPBTClient, public Component
+        {
+        public:
+            void setup() override;
+            void loop() override;
+            float get_setup_priority() const override { return setup_priority::AFTER_BLUETOOTH; }
+
+            bool gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param) override;
+            void connect() override;
+            void set_state(espbt::ClientState state) override;
+
+            void set_enabled(bool enabled);
+            void register_ble_node(BLEClientNode *node)
+            {
+                node->set_ble_client_parent(this);
+                this->nodes_.push_back(node);
+            }
+
+            BLEService *get_service(espbt::ESPBTUUID uuid);
+            BLECharacteristic *get_characteristic(espbt::ESPBTUUID service, espbt::ESPBTUUID chr);
+
+            void set_address(uint64_t address);
+            uint64_t get_address() const { return this->address_; }
+            std::string address_str() const;
+            uint8_t *get_remote_bda() { return this->remote_bda_; }
+            esp_gatt_if_t get_gattc_if() const { return this->gattc_if_; }
+            uint16_t get_conn_id() const { return this->conn_id_; }
+
+            bool enabled = false;
+
+        protected:
+            bool all_nodes_established_();
+            void discover_services_();
+
+            std::vector<BLEClientNode *> nodes_;
+            std::vector<std::unique_ptr<BLEService>> services_;
+            uint64_t address_ = 0;
+            esp_bd_addr_t remote_bda_ = {0};
+            esp_gatt_if_t gattc_if_ = ESP_GATT_IF_NONE;
+            uint16_t conn_id_ = 0;
+        };
+    } // namespace ble_client
+} // namespace esphome
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "esphome/components/climate/climate_mode.h"
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+#include <cmath>
+#include <set>
+
+#define LOG_CLIMATE(prefix, type, obj) ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name().c_str())
+
+namespace esphome
+{
+    namespace climate
+    {
+        class Climate;
+
+        // the traits are not checked by the host tests
+        class ClimateTraits
+        {
+        public:
+            void set_supports_current_temperature(bool) {}
+            void set_supported_modes(std::set<ClimateMode>) {}
+            void set_visual_temperature_step(float) {}
+            void set_supports_action(bool) {}
+        };
+
+        class ClimateCall
+        {
+        public:
+            explicit ClimateCall(Climate *parent) : parent_(parent) {}
+
+            ClimateCall &set_mode(ClimateMode mode)
+            {
+                this->mode_ = mode;
+                return *this;
+            }
+            ClimateCall &set_target_temperature(float target_temperature)
+            {
+                this->target_temperature_ = target_temperature;
+                return *this;
+            }
+            void perform();
+
+            const optional<ClimateMode> &get_mode() const { return this->mode_; }
+            const optional<float> &get_target_temperature() const { return this->target_temperature_; }
+
+        protected:
+            Climate *parent_;
+            optional<ClimateMode> mode_;
+            optional<float> target_temperature_;
+        };
+
+        class Climate : public EntityBase
+        {
+        public:
+            ClimateCall make_call() { return ClimateCall(this); }
+
+            void publish_state() { this->state_callback_.call(*this); }
+            void add_on_state_callback(std::function<void(Climate &)> &&callback) { this->state_callback_.add(std::move(callback)); }
+
+            virtual ClimateTraits traits() = 0;
+
+            void set_visual_min_temperature_override(float visual_min_temperature_override) { this->visual_min_temperature_override = visual_min_temperature_override; }
+            void set_visual_max_temperature_override(float visual_max_temperature_override) { this->visual_max_temperature_override = visual_max_temperature_override; }
+
+            ClimateMode mode{CLIMATE_MODE_OFF};
+            ClimateAction action{CLIMATE_ACTION_OFF};
+            float current_temperature{NAN};
+            float target_temperature{NAN};
+            float visual_min_temperature_override{NAN};
+            float visual_max_temperature_override{NAN};
+
+        protected:
+            friend ClimateCall;
+
+            virtual void control(const ClimateCall &call) = 0;
+
+            CallbackManager<void(Climate &)> state_callback_;
+        };
+
+        inline void ClimateCall::perform() { this->parent_->control(*this); }
+    } // namespace climate
+} // namespace esphome
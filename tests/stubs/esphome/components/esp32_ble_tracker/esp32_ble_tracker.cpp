@@ -0,0 +1,23 @@
+#include "esp32_ble_tracker.h"
+
+namespace esphome
+{
+    namespace esp32_ble_tracker
+    {
+        ESP32BLETracker *global_esp32_ble_tracker = nullptr;
+
+        ESP32BLETracker::ESP32BLETracker() { global_esp32_ble_tracker = this; }
+
+        void ESP32BLETracker::register_client(ESPBTClient *client)
+        {
+            client->app_id = ++this->app_count_;
+            this->clients_.push_back(client);
+        }
+
+        void ESP32BLETracker::gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param)
+        {
+            for (auto *client : this->clients_)
+                client->gattc_event_handler(event, gattc_if, param);
+        }
+    } // namespace esp32_ble_tracker
+} // namespace esphome
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "esphome/core/component.h"
+
+#include <esp_bt_defs.h>
+#include <esp_gap_ble_api.h>
+#include <esp_gattc_api.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace esphome
+{
+    namespace esp32_ble_tracker
+    {
+        enum class ClientState
+        {
+            INIT = 0,
+            DISCONNECTING,
+            IDLE,
+            SEARCHING,
+            DISCOVERED,
+            READY_TO_CONNECT,
+            CONNECTING,
+            CONNECTED,
+            ESTABLISHED
+        };
+
+        class ESPBTUUID
+        {
+        public:
+            ESPBTUUID() { this->uuid_.len = 0; }
+
+            static ESPBTUUID from_uint16(uint16_t uuid)
+            {
+                ESPBTUUID ret;
+                ret.uuid_.len = ESP_UUID_LEN_16;
+                ret.uuid_.uuid.uuid16 = uuid;
+                return ret;
+            }
+
+            static ESPBTUUID from_uint32(uint32_t uuid)
+            {
+                ESPBTUUID ret;
+                ret.uuid_.len = ESP_UUID_LEN_32;
+                ret.uuid_.uuid.uuid32 = uuid;
+                return ret;
+            }
+
+            // 128 bit uuid in the canonical form, bytes are stored little-endian like in ESP-IDF
+            static ESPBTUUID from_raw(const std::string &data)
+            {
+                ESPBTUUID ret;
+                ret.uuid_.len = ESP_UUID_LEN_128;
+                size_t n = 0;
+                for (size_t i = 0; i + 1 < data.length() && n < ESP_UUID_LEN_128; i++)
+                {
+                    if (data[i] == '-')
+                        continue;
+                    unsigned byte;
+                    sscanf(data.c_str() + i, "%2x", &byte);
+                    ret.uuid_.uuid.uuid128[ESP_UUID_LEN_128 - 1 - n++] = byte;
+                    i++;
+                }
+                return ret;
+            }
+
+            static ESPBTUUID from_uuid(esp_bt_uuid_t uuid)
+            {
+                ESPBTUUID ret;
+                ret.uuid_ = uuid;
+                return ret;
+            }
+
+            esp_bt_uuid_t get_uuid() const { return this->uuid_; }
+
+            // uuids of different lengths are compared as 128 bit uuids
+            bool operator==(const ESPBTUUID &other) const
+            {
+                if (this->uuid_.len != other.uuid_.len)
+                    return this->as_128bit() == other.as_128bit();
+
+                switch (this->uuid_.len)
+                {
+                case ESP_UUID_LEN_16:
+                    return this->uuid_.uuid.uuid16 == other.uuid_.uuid.uuid16;
+                case ESP_UUID_LEN_32:
+                    return this->uuid_.uuid.uuid32 == other.uuid_.uuid.uuid32;
+                default:
+                    return memcmp(this->uuid_.uuid.uuid128, other.uuid_.uuid.uuid128, ESP_UUID_LEN_128) == 0;
+                }
+            }
+
+            // a 16 or 32 bit uuid expanded with the Bluetooth base uuid 00000000-0000-1000-8000-00805f9b34fb
+            ESPBTUUID as_128bit() const
+            {
+                if (this->uuid_.len == ESP_UUID_LEN_128)
+                    return *this;
+
+                static const uint8_t base[ESP_UUID_LEN_128] = {0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0, 0, 0, 0};
+                uint32_t value = this->uuid_.len == ESP_UUID_LEN_16 ? this->uuid_.uuid.uuid16 : this->uuid_.uuid.uuid32;
+
+                ESPBTUUID ret;
+                ret.uuid_.len = ESP_UUID_LEN_128;
+                memcpy(ret.uuid_.uuid.uuid128, base, ESP_UUID_LEN_128);
+                for (int i = 0; i < 4; i++)
+                    ret.uuid_.uuid.uuid128[12 + i] = value >> (8 * i);
+                return ret;
+            }
+
+            std::string to_string() const
+            {
+                char buff[40];
+                if (this->uuid_.len == ESP_UUID_LEN_16)
+                    snprintf(buff, sizeof(buff), "0x%04X", this->uuid_.uuid.uuid16);
+                else if (this->uuid_.len == ESP_UUID_LEN_32)
+                    snprintf(buff, sizeof(buff), "0x%08X", this->uuid_.uuid.uuid32);
+                else
+                {
+                    char *p = buff;
+                    for (int i = ESP_UUID_LEN_128 - 1; i >= 0; i--)
+                    {
+                        p += sprintf(p, "%02x", this->uuid_.uuid.uuid128[i]);
+                        if (i == 12 || i == 10 || i == 8 || i == 6)
+                            *p++ = '-';
+                    }
+                }
+                return buff;
+            }
+
+        protected:
+            esp_bt_uuid_t uuid_;
+        };
+
+        class ESPBTClient
+        {
+        public:
+            virtual bool gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t esp_gattc_if, esp_ble_gattc_cb_param_t *param) = 0;
+            virtual void connect() = 0;
+            virtual void set_state(ClientState st) { this->state_ = st; }
+            ClientState state() const { return this->state_; }
+
+            int app_id;
+
+        protected:
+            ClientState state_ = ClientState::INIT;
+        };
+
+        // Scanning is not simulated: the tracker only hands the GATT events to all clients.
+        // A client connects from its own loop(), once it is READY_TO_CONNECT
+        class ESP32BLETracker : public Component
+        {
+        public:
+            ESP32BLETracker();
+
+            float get_setup_priority() const override { return setup_priority::BLUETOOTH; }
+
+            void register_client(ESPBTClient *client);
+            void gattc_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param);
+
+        protected:
+            std::vector<ESPBTClient *> clients_;
+            uint8_t app_count_ = 0;
+        };
+
+        extern ESP32BLETracker *global_esp32_ble_tracker;
+    } // namespace esp32_ble_tracker
+} // namespace esphome
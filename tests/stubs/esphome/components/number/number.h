@@ -0,0 +1,30 @@
+#pragma once
+
+#include "esphome/core/entity_base.h"
+
+#include <cmath>
+
+namespace esphome
+{
+    namespace number
+    {
+        class Number : public EntityBase
+        {
+        public:
+            void make_call(float value) { this->control(value); }
+            void publish_state(float state)
+            {
+                this->state = state;
+                this->has_state_ = true;
+            }
+            bool has_state() const { return this->has_state_; }
+
+            float state{NAN};
+
+        protected:
+            virtual void control(float value) = 0;
+
+            bool has_state_ = false;
+        };
+    } // namespace number
+} // namespace esphome
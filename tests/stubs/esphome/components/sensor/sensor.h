@@ -0,0 +1,41 @@
+#pragma once
+
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+#include <cmath>
+
+#define LOG_SENSOR(prefix, type, obj)                                              \
+    if ((obj) != nullptr)                                                          \
+    {                                                                              \
+        ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name().c_str()); \
+    }
+
+namespace esphome
+{
+    namespace sensor
+    {
+        // filters are not simulated, the published state is the raw state
+        class Sensor : public EntityBase
+        {
+        public:
+            void publish_state(float state)
+            {
+                this->raw_state = state;
+                this->state = state;
+                this->has_state_ = true;
+                this->callback_.call(state);
+            }
+            void add_on_state_callback(std::function<void(float)> &&callback) { this->callback_.add(std::move(callback)); }
+            bool has_state() const { return this->has_state_; }
+
+            float state{NAN};
+            float raw_state{NAN};
+
+        protected:
+            bool has_state_ = false;
+            CallbackManager<void(float)> callback_;
+        };
+    } // namespace sensor
+} // namespace esphome
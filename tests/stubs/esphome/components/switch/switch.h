@@ -0,0 +1,22 @@
+#pragma once
+
+#include "esphome/core/entity_base.h"
+
+namespace esphome
+{
+    namespace switch_
+    {
+        class Switch : public EntityBase
+        {
+        public:
+            void turn_on() { this->write_state(true); }
+            void turn_off() { this->write_state(false); }
+            void publish_state(bool state) { this->state = state; }
+
+            bool state{false};
+
+        protected:
+            virtual void write_state(bool state) = 0;
+        };
+    } // namespace switch_
+} // namespace esphome
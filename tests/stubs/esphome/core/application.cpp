@@ -0,0 +1,135 @@
+#include "esphome/core/application.h"
+#include "esphome/core/log.h"
+
+#include <algorithm>
+
+namespace esphome
+{
+    Application App;
+
+    uint32_t millis() { return App.get_time(); }
+
+    Application::Application() { host_log_clock = millis; }
+
+    void Application::setup()
+    {
+        stable_sort(this->components_.begin(), this->components_.end(), [](Component *a, Component *b)
+                    { return a->get_setup_priority() > b->get_setup_priority(); });
+
+        for (auto *component : this->components_)
+            component->call_setup();
+    }
+
+    void Application::loop()
+    {
+        this->scheduler.call();
+
+        for (auto *component : this->components_)
+            if (!component->is_failed())
+                component->loop();
+    }
+
+    void Application::reset()
+    {
+        this->components_.clear();
+        this->scheduler.clear();
+        this->time_ = 0;
+    }
+
+    void Scheduler::set_timeout(Component *component, const std::string &name, uint32_t timeout, std::function<void()> func)
+    {
+        this->add(component, name, false, 0, timeout, std::move(func));
+    }
+
+    bool Scheduler::cancel_timeout(Component *component, const std::string &name) { return this->cancel(component, name, false); }
+
+    void Scheduler::set_interval(Component *component, const std::string &name, uint32_t interval, std::function<void()> func)
+    {
+        this->add(component, name, true, interval, interval, std::move(func));
+    }
+
+    bool Scheduler::cancel_interval(Component *component, const std::string &name) { return this->cancel(component, name, true); }
+
+    void Scheduler::add(Component *component, const std::string &name, bool interval, uint32_t period, uint32_t delay, std::function<void()> func)
+    {
+        this->cancel(component, name, interval);
+        this->to_add_.push_back(std::unique_ptr<Item>(new Item{component, name, interval, period, millis() + delay, std::move(func), false}));
+    }
+
+    bool Scheduler::cancel(Component *component, const std::string &name, bool interval)
+    {
+        bool cancelled = false;
+        for (auto *items : {&this->items_, &this->to_add_})
+            for (auto &item : *items)
+                if (!item->removed && item->component == component && item->interval == interval && item->name == name)
+                {
+                    item->removed = true;
+                    cancelled = true;
+                }
+        return cancelled;
+    }
+
+    void Scheduler::call()
+    {
+        for (auto &item : this->to_add_)
+            this->items_.push_back(std::move(item));
+        this->to_add_.clear();
+
+        uint32_t now = millis();
+        for (;;)
+        {
+            // the earliest item first, callbacks only flag the removed items, so the pointer stays valid
+            Item *due = nullptr;
+            for (auto &item : this->items_)
+                if (!item->removed && (int32_t)(now - item->next) >= 0 && (due == nullptr || (int32_t)(item->next - due->next) < 0))
+                    due = item.get();
+            if (due == nullptr)
+                break;
+
+            if (due->component != nullptr && due->component->is_failed())
+            {
+                due->removed = true;
+                continue;
+            }
+
+            // an interval, which fell behind, runs once per call
+            if (due->interval && due->period > 0)
+                due->next += ((now - due->next) / due->period + 1) * due->period;
+            else
+                due->removed = true;
+
+            due->callback();
+        }
+
+        this->items_.erase(std::remove_if(this->items_.begin(), this->items_.end(), [](const std::unique_ptr<Item> &item)
+                                          { return item->removed; }),
+                           this->items_.end());
+    }
+
+    void Scheduler::clear()
+    {
+        this->items_.clear();
+        this->to_add_.clear();
+    }
+
+    void Component::set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f)
+    {
+        App.scheduler.set_interval(this, name, interval, std::move(f));
+    }
+
+    bool Component::cancel_interval(const std::string &name) { return App.scheduler.cancel_interval(this, name); }
+
+    void Component::set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f)
+    {
+        App.scheduler.set_timeout(this, name, timeout, std::move(f));
+    }
+
+    bool Component::cancel_timeout(const std::string &name) { return App.scheduler.cancel_timeout(this, name); }
+
+    void PollingComponent::call_setup()
+    {
+        this->setup();
+        this->set_interval("update", this->get_update_interval(), [this]()
+                           { this->update(); });
+    }
+} // namespace esphome
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "esphome/core/component.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace esphome
+{
+    // timeouts and intervals of the components, like the ESPHome scheduler: an item replaces the item of the same
+    // component with the same name, items added by a callback are only considered by the next call()
+    class Scheduler
+    {
+    public:
+        void set_timeout(Component *component, const std::string &name, uint32_t timeout, std::function<void()> func);
+        bool cancel_timeout(Component *component, const std::string &name);
+        void set_interval(Component *component, const std::string &name, uint32_t interval, std::function<void()> func);
+        bool cancel_interval(Component *component, const std::string &name);
+
+        // runs the items, which are due
+        void call();
+        void clear();
+
+    protected:
+        struct Item
+        {
+            Component *component;
+            std::string name;
+            bool interval;
+            uint32_t period;
+            uint32_t next;
+            std::function<void()> callback;
+            bool removed;
+        };
+
+        void add(Component *component, const std::string &name, bool interval, uint32_t period, uint32_t delay, std::function<void()> func);
+        bool cancel(Component *component, const std::string &name, bool interval);
+
+        std::vector<std::unique_ptr<Item>> items_;
+        std::vector<std::unique_ptr<Item>> to_add_;
+    };
+
+    // Host replacement of the ESPHome application. Time does not pass on its own: the simulator sets the clock,
+    // which is returned by millis(), and runs the main loop at the loop interval.
+    class Application
+    {
+    public:
+        Application();
+
+        void register_component(Component *component) { this->components_.push_back(component); }
+        const std::vector<Component *> &get_components() const { return this->components_; }
+
+        // components are set up in the order of their setup priority
+        void setup();
+        void loop();
+
+        uint32_t get_time() const { return this->time_; }
+        void set_time(uint32_t time) { this->time_ = time; }
+
+        // forgets the components and their timers, and resets the clock. Components are never freed, like on the device
+        void reset();
+
+        Scheduler scheduler;
+
+    protected:
+        std::vector<Component *> components_;
+        uint32_t time_ = 0;
+    };
+
+    extern Application App;
+} // namespace esphome
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "esphome/core/entity_base.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome
+{
+    namespace setup_priority
+    {
+        const float BUS = 1000.0f;
+        const float IO = 900.0f;
+        const float HARDWARE = 800.0f;
+        const float DATA = 600.0f;
+        const float PROCESSOR = 400.0f;
+        const float BLUETOOTH = 350.0f;
+        const float AFTER_BLUETOOTH = 300.0f;
+        const float WIFI = 250.0f;
+        const float LATE = -100.0f;
+    } // namespace setup_priority
+
+    // timeouts and intervals are run by App.scheduler on the simulated clock
+    class Component
+    {
+    public:
+        virtual ~Component() = default;
+
+        virtual void setup() {}
+        virtual void loop() {}
+        virtual void dump_config() {}
+        virtual float get_setup_priority() const { return setup_priority::DATA; }
+        virtual void call_setup() { this->setup(); }
+
+        // a failed component is neither looped nor are its timeouts run
+        void mark_failed() { this->failed_ = true; }
+        bool is_failed() const { return this->failed_; }
+
+        void status_set_error() { this->status_error_ = true; }
+        void status_clear_error() { this->status_error_ = false; }
+        bool status_has_error() const { return this->status_error_; }
+
+    protected:
+        void set_interval(const std::string &name, uint32_t interval, std::function<void()> &&f);
+        bool cancel_interval(const std::string &name);
+        void set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f);
+        bool cancel_timeout(const std::string &name);
+
+        bool failed_ = false;
+        bool status_error_ = false;
+    };
+
+    class PollingComponent : public Component
+    {
+    public:
+        PollingComponent() : PollingComponent(0) {}
+        explicit PollingComponent(uint32_t update_interval) : update_interval_(update_interval) {}
+
+        virtual void update() = 0;
+        void call_setup() override;
+
+        virtual void set_update_interval(uint32_t update_interval) { this->update_interval_ = update_interval; }
+        virtual uint32_t get_update_interval() const { return this->update_interval_; }
+
+    protected:
+        uint32_t update_interval_;
+    };
+} // namespace esphome
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome
+{
+    // the simulated clock of App
+    uint32_t millis();
+} // namespace esphome
@@ -0,0 +1,30 @@
+#include "esphome/core/helpers.h"
+
+namespace esphome
+{
+    uint32_t fnv1_hash(const std::string &str)
+    {
+        uint32_t hash = 2166136261UL;
+        for (char c : str)
+        {
+            hash *= 16777619UL;
+            hash ^= c;
+        }
+        return hash;
+    }
+
+    std::string format_hex_pretty(const uint8_t *data, size_t length)
+    {
+        if (length == 0)
+            return "";
+
+        std::string ret;
+        char buff[4];
+        for (size_t i = 0; i < length; i++)
+        {
+            snprintf(buff, sizeof(buff), i + 1 < length ? "%02X." : "%02X", data[i]);
+            ret += buff;
+        }
+        return ret + " (" + std::to_string(length) + ")";
+    }
+} // namespace esphome
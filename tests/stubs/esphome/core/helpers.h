@@ -0,0 +1,33 @@
+#pragma once
+
+#include "esphome/core/optional.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace esphome
+{
+    uint32_t fnv1_hash(const std::string &str);
+    std::string format_hex_pretty(const uint8_t *data, size_t length);
+
+    template <typename... Ts>
+    class CallbackManager;
+
+    template <typename... Ts>
+    class CallbackManager<void(Ts...)>
+    {
+    public:
+        void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+        void call(Ts... args)
+        {
+            for (auto &callback : this->callbacks_)
+                callback(args...);
+        }
+
+    protected:
+        std::vector<std::function<void(Ts...)>> callbacks_;
+    };
+} // namespace esphome
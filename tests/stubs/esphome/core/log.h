@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+// Host replacement of the ESPHome logger. Nothing is logged, unless a test raises host_log_level
+
+#define ESPHOME_LOG_LEVEL_NONE 0
+#define ESPHOME_LOG_LEVEL_ERROR 1
+#define ESPHOME_LOG_LEVEL_WARN 2
+#define ESPHOME_LOG_LEVEL_INFO 3
+#define ESPHOME_LOG_LEVEL_CONFIG 4
+#define ESPHOME_LOG_LEVEL_DEBUG 5
+#define ESPHOME_LOG_LEVEL_VERBOSE 6
+
+namespace esphome
+{
+    inline int host_log_level = ESPHOME_LOG_LEVEL_NONE;
+    // prefixes the lines with the simulated time, once the application has set it
+    inline uint32_t (*host_log_clock)() = nullptr;
+
+    inline void host_log(int level, const char *tag, const char *format, ...)
+    {
+        if (level > host_log_level)
+            return;
+
+        if (host_log_clock != nullptr)
+            printf("[%9u]", host_log_clock());
+        printf("[%c][%s] ", "NEWICDV"[level], tag);
+
+        va_list args;
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+        putchar('\n');
+    }
+} // namespace esphome
+
+#define ESP_LOGE(tag, ...) esphome::host_log(ESPHOME_LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) esphome::host_log(ESPHOME_LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) esphome::host_log(ESPHOME_LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) esphome::host_log(ESPHOME_LOG_LEVEL_CONFIG, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) esphome::host_log(ESPHOME_LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) esphome::host_log(ESPHOME_LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
@@ -0,0 +1,29 @@
+#include "esphome/core/preferences.h"
+
+namespace esphome
+{
+    static ESPPreferences preferences;
+    ESPPreferences *global_preferences = &preferences;
+
+    bool ESPPreferenceObject::save_(const uint8_t *data)
+    {
+        if (!this->valid_)
+            return false;
+
+        global_preferences->values[this->key_].assign(data, data + this->length_);
+        return true;
+    }
+
+    bool ESPPreferenceObject::load_(uint8_t *data)
+    {
+        if (!this->valid_)
+            return false;
+
+        auto it = global_preferences->values.find(this->key_);
+        if (it == global_preferences->values.end() || it->second.size() != this->length_)
+            return false;
+
+        std::copy(it->second.begin(), it->second.end(), data);
+        return true;
+    }
+} // namespace esphome
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace esphome
+{
+    // flash, which keeps the saved values in memory for the lifetime of the process
+    class ESPPreferenceObject
+    {
+    public:
+        ESPPreferenceObject() = default;
+        ESPPreferenceObject(uint32_t key, size_t length) : key_(key), length_(length), valid_(true) {}
+
+        template <typename T>
+        bool save(const T *src) { return sizeof(T) == this->length_ && this->save_(reinterpret_cast<const uint8_t *>(src)); }
+
+        template <typename T>
+        bool load(T *dest) { return sizeof(T) == this->length_ && this->load_(reinterpret_cast<uint8_t *>(dest)); }
+
+    protected:
+        bool save_(const uint8_t *data);
+        bool load_(uint8_t *data);
+
+        uint32_t key_ = 0;
+        size_t length_ = 0;
+        bool valid_ = false;
+    };
+
+    class ESPPreferences
+    {
+    public:
+        template <typename T>
+        ESPPreferenceObject make_preference(uint32_t type, bool in_flash) { return ESPPreferenceObject(type, sizeof(T)); }
+
+        bool sync()
+        {
+            this->syncs++;
+            return true;
+        }
+
+        void reset()
+        {
+            this->values.clear();
+            this->syncs = 0;
+        }
+
+        std::map<uint32_t, std::vector<uint8_t>> values;
+        uint32_t syncs = 0;
+    };
+
+    extern ESPPreferences *global_preferences;
+} // namespace esphome
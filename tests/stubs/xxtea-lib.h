@@ -0,0 +1,12 @@
+#pragma once
+
+// Host replacement of the xxtea-iot-crypt header, only the status codes are used by xxtea.h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define XXTEA_STATUS_SUCCESS 0
+#define XXTEA_STATUS_GENERAL_ERROR 1
+#define XXTEA_STATUS_PARAMETER_ERROR 2
+#define XXTEA_STATUS_SIZE_ERROR 3
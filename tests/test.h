@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the host tests, a failed check is reported and fails the test at exit
+
+static int test_failures = 0;
+
+#define CHECK(condition)                                                    \
+    do                                                                      \
+    {                                                                       \
+        if (!(condition))                                                   \
+        {                                                                   \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            test_failures++;                                                \
+        }                                                                   \
+    } while (0)
+
+inline int test_result(const char *name)
+{
+    if (test_failures == 0)
+        printf("%s: passed\n", name);
+    else
+        fprintf(stderr, "%s: %d checks failed\n", name, test_failures);
+    return test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,57 @@
+#include "xxtea.h"
+
+#include "reference_xxtea.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Time per value of XxteaBlock against the previous path, for the value lengths of the protocol.
+// usage: xxtea_benchmark [iterations]
+
+static const size_t LENGTHS[] = {8, 16};
+
+template <class F>
+static double measure(long iterations, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++)
+        f();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+    if (iterations <= 0)
+        return EXIT_FAILURE;
+
+    uint8_t raw_key[16];
+    for (size_t i = 0; i < sizeof(raw_key); i++)
+        raw_key[i] = i;
+    XxteaKey key;
+    key.set(raw_key, sizeof(raw_key));
+
+    printf("%-6s %-8s %12s %12s\n", "length", "", "previous", "XxteaBlock");
+    for (size_t len : LENGTHS)
+    {
+        uint8_t value[16] = {0};
+        // the value is fed back, so the compiler can not drop the loop
+        double previous_encrypt = measure(iterations, [&]()
+                                          { reference::crypt(raw_key, value, len, true); });
+        double block_encrypt = measure(iterations, [&]()
+                                       { xxtea_encrypt(key, value, len); });
+        double previous_decrypt = measure(iterations, [&]()
+                                          { reference::crypt(raw_key, value, len, false); });
+        double block_decrypt = measure(iterations, [&]()
+                                       { xxtea_decrypt(key, value, len); });
+
+        printf("%-6zu %-8s %9.1f ns %9.1f ns\n", len, "encrypt", previous_encrypt, block_encrypt);
+        printf("%-6zu %-8s %9.1f ns %9.1f ns\n", len, "decrypt", previous_decrypt, block_decrypt);
+
+        volatile uint8_t sink = value[0];
+        (void)sink;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+#include "xxtea.h"
+
+#include "test.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Many threads encrypt and decrypt with a single key at the same time, as the BT task and the main loop do.
+// The key is set while the threads are already running, a thread may only use it once status() reports it.
+// Build with -DCMAKE_CXX_FLAGS=-fsanitize=thread to check for data races.
+
+static const size_t THREADS = 8;
+static const int ITERATIONS = 20000;
+
+int main()
+{
+    uint8_t raw_key[16];
+    for (size_t i = 0; i < sizeof(raw_key); i++)
+        raw_key[i] = i * 13 + 1;
+
+    // expected values, computed with a key of their own
+    uint8_t plain[16], cipher8[16], cipher16[16];
+    for (size_t i = 0; i < sizeof(plain); i++)
+        plain[i] = i * 7;
+    {
+        XxteaKey key;
+        key.set(raw_key, sizeof(raw_key));
+        memcpy(cipher8, plain, 16);
+        memcpy(cipher16, plain, 16);
+        xxtea_encrypt(key, cipher8, 8);
+        xxtea_encrypt(key, cipher16, 16);
+    }
+
+    XxteaKey key;
+    std::atomic<int> mismatches{0};
+    std::atomic<int> not_ready{0};
+    std::atomic<bool> start{false};
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; t++)
+        threads.emplace_back([&, t]()
+                             {
+                                 while (!start.load())
+                                     ;
+
+                                 for (int i = 0; i < ITERATIONS; i++)
+                                 {
+                                     size_t len = (i + t) % 2 == 0 ? 8 : 16;
+                                     const uint8_t *expected = len == 8 ? cipher8 : cipher16;
+
+                                     uint8_t value[16];
+                                     memcpy(value, plain, len);
+                                     if (xxtea_encrypt(key, value, len) != XXTEA_STATUS_SUCCESS)
+                                     {
+                                         not_ready++;
+                                         continue;
+                                     }
+                                     if (memcmp(value, expected, len) != 0)
+                                         mismatches++;
+
+                                     if (xxtea_decrypt(key, value, len) != XXTEA_STATUS_SUCCESS || memcmp(value, plain, len) != 0)
+                                         mismatches++;
+                                 } });
+
+    start.store(true);
+    std::this_thread::yield();
+    key.set(raw_key, sizeof(raw_key));
+
+    for (auto &thread : threads)
+        thread.join();
+
+    printf("xxtea_stress_test: %zu threads, %d values each, %d before the key was set\n", THREADS, ITERATIONS, not_ready.load());
+    CHECK(mismatches.load() == 0);
+    return test_result("xxtea_stress_test");
+}
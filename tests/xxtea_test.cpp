@@ -0,0 +1,122 @@
+#include "xxtea.h"
+
+#include "reference_xxtea.h"
+#include "test.h"
+
+#include <random>
+
+static const size_t LENGTHS[] = {8, 16};
+
+// Known-answer vectors, produced by the previous xxtea-iot-crypt path. Values are in the byte order of the device.
+struct Vector
+{
+    uint8_t key[16];
+    uint8_t plain[16];
+    uint8_t cipher[16];
+    size_t len;
+};
+
+static const Vector VECTORS[] = {
+    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+     {0x05, 0x37, 0x04, 0xab, 0x57, 0x5d, 0x8c, 0x80},
+     8},
+    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+     {0xe6, 0xc8, 0xd5, 0xff, 0x07, 0x0f, 0xb6, 0xe4, 0x98, 0xa5, 0x34, 0xf7, 0xac, 0x03, 0xe3, 0x99},
+     16},
+    {{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f},
+     {0x01, 0x12, 0x23, 0x34, 0x45, 0x56, 0x67, 0x78},
+     {0x9e, 0x7a, 0xd2, 0xa1, 0x8a, 0xb7, 0x94, 0x59},
+     8},
+    {{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f},
+     {0x01, 0x12, 0x23, 0x34, 0x45, 0x56, 0x67, 0x78, 0x89, 0x9a, 0xab, 0xbc, 0xcd, 0xde, 0xef, 0x00},
+     {0x20, 0x41, 0xfa, 0x27, 0x3b, 0xfc, 0xa7, 0xb1, 0x21, 0x64, 0x92, 0xd0, 0x9b, 0x40, 0x26, 0x1a},
+     16},
+    {{0xff, 0xf8, 0xf1, 0xea, 0xe3, 0xdc, 0xd5, 0xce, 0xc7, 0xc0, 0xb9, 0xb2, 0xab, 0xa4, 0x9d, 0x96},
+     {0x02, 0x13, 0x24, 0x35, 0x46, 0x57, 0x68, 0x79},
+     {0x54, 0x72, 0xaa, 0x63, 0x4d, 0x97, 0x03, 0x01},
+     8},
+    {{0xff, 0xf8, 0xf1, 0xea, 0xe3, 0xdc, 0xd5, 0xce, 0xc7, 0xc0, 0xb9, 0xb2, 0xab, 0xa4, 0x9d, 0x96},
+     {0x02, 0x13, 0x24, 0x35, 0x46, 0x57, 0x68, 0x79, 0x8a, 0x9b, 0xac, 0xbd, 0xce, 0xdf, 0xf0, 0x01},
+     {0xd8, 0x31, 0x04, 0x0d, 0x15, 0x48, 0x1f, 0x4d, 0xef, 0x1e, 0x5b, 0xcf, 0x08, 0x13, 0x14, 0x80},
+     16},
+};
+
+static void test_vectors()
+{
+    for (auto &vector : VECTORS)
+    {
+        XxteaKey key;
+        CHECK(key.set(vector.key, sizeof(vector.key)) == XXTEA_STATUS_SUCCESS);
+
+        uint8_t value[16];
+        memcpy(value, vector.plain, vector.len);
+        CHECK(xxtea_encrypt(key, value, vector.len) == XXTEA_STATUS_SUCCESS);
+        CHECK(memcmp(value, vector.cipher, vector.len) == 0);
+
+        CHECK(xxtea_decrypt(key, value, vector.len) == XXTEA_STATUS_SUCCESS);
+        CHECK(memcmp(value, vector.plain, vector.len) == 0);
+    }
+}
+
+// random keys and values give the same result as the reference path
+static void test_reference()
+{
+    std::mt19937 random(1);
+    for (int i = 0; i < 10000; i++)
+    {
+        uint8_t raw_key[16];
+        for (auto &b : raw_key)
+            b = random();
+        XxteaKey key;
+        key.set(raw_key, sizeof(raw_key));
+
+        for (size_t len : LENGTHS)
+        {
+            uint8_t value[16], expected[16], plain[16];
+            for (size_t j = 0; j < len; j++)
+                plain[j] = random();
+            memcpy(value, plain, len);
+            memcpy(expected, plain, len);
+
+            xxtea_encrypt(key, value, len);
+            reference::crypt(raw_key, expected, len, true);
+            CHECK(memcmp(value, expected, len) == 0);
+
+            xxtea_decrypt(key, value, len);
+            reference::crypt(raw_key, expected, len, false);
+            CHECK(memcmp(value, expected, len) == 0);
+            CHECK(memcmp(value, plain, len) == 0);
+        }
+    }
+}
+
+static void test_errors()
+{
+    uint8_t value[16] = {0};
+
+    XxteaKey key;
+    CHECK(key.status() == XXTEA_STATUS_NOT_INITIALIZED);
+    CHECK(xxtea_encrypt(key, value, 8) == XXTEA_STATUS_GENERAL_ERROR);
+
+    uint8_t raw_key[16] = {0};
+    CHECK(key.set(nullptr, 16) == XXTEA_STATUS_PARAMETER_ERROR);
+    CHECK(key.set(raw_key, 17) == XXTEA_STATUS_PARAMETER_ERROR);
+    CHECK(key.set(raw_key, 16) == XXTEA_STATUS_SUCCESS);
+
+    CHECK(xxtea_encrypt(key, nullptr, 8) == XXTEA_STATUS_PARAMETER_ERROR);
+    for (size_t len : {0, 1, 4, 7, 9, 12, 15, 17})
+    {
+        CHECK(xxtea_encrypt(key, value, len) == XXTEA_STATUS_SIZE_ERROR);
+        CHECK(xxtea_decrypt(key, value, len) == XXTEA_STATUS_SIZE_ERROR);
+    }
+}
+
+int main()
+{
+    test_vectors();
+    test_reference();
+    test_errors();
+    return test_result("xxtea_test");
+}